@@ -1,6 +1,14 @@
 #ifndef ALLOCATOR_INTERFACE_H
 #define ALLOCATOR_INTERFACE_H
 
+#include <stddef.h>
+
+#if defined(_MSC_VER)
+#define ALLOCATOR_THREAD_LOCAL		__declspec(thread)
+#else
+#define ALLOCATOR_THREAD_LOCAL		_Thread_local
+#endif
+
 typedef struct {
     void*		(*malloc)(size_t);
     void 		(*free)(void *);
@@ -8,6 +16,7 @@ typedef struct {
     void*		(*calloc)(size_t, size_t);
 } AllocatorInterface;
 
+extern AllocatorInterface DefaultAllocator;
 extern AllocatorInterface* CurrentAllocator;
 
 #endif
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef ARENA_ALLOCATOR_INTERFACE_H
+#define ARENA_ALLOCATOR_INTERFACE_H
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#include "allocator_i.h"
+
+#define ARENA_DEFAULT_CHUNK_SIZE						(64 * 1024)
+#define ARENA_ALIGNMENT											16
+
+typedef struct Arena_t* Arena;
+typedef struct arena_chunk_t arena_chunk_t;
+
+//position inside arena, used to rewind it back
+typedef struct {
+	arena_chunk_t*	chunk;
+	size_t					used;
+} arena_mark_t;
+
+typedef struct {
+	//live cycle
+	Arena								(*construct)(size_t chunk_size);
+	void								(*destruct)(Arena arena);
+
+	//binding: ArenaAllocator serves the arena bound to the calling thread
+	AllocatorInterface*	(*bind)(Arena arena);
+	Arena								(*current)(void);
+
+	//bulk release
+	void								(*reset)(Arena arena);
+	arena_mark_t				(*mark)(const Arena arena);
+	void								(*rewind)(Arena arena, arena_mark_t mark);
+
+	//state
+	size_t							(*used)(const Arena arena);
+	size_t							(*reserved)(const Arena arena);
+} ArenaInterface_t;
+
+extern ArenaInterface_t iArena;
+
+//malloc/calloc bump-allocate from the bound arena, realloc grows in place
+//when the block is the last one handed out, free is a no-op
+extern AllocatorInterface ArenaAllocator;
+
+#endif
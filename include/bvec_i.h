@@ -0,0 +1,72 @@
+#ifndef BIT_VECTOR_INTERFACE_H
+#define BIT_VECTOR_INTERFACE_H
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#include "allocator_i.h"
+#include "vec_i.h"
+
+//words per rank/select sample: rank reads at most this many words after the sample
+#define BVEC_RANK_SAMPLE_WORDS							8
+
+typedef struct tagBitVector* BVec;
+
+//packed bits in 64-bit words, bit i is bit i % 64 of word i / 64. Bits past size in the
+//last word are always 0. Bulk operations work on whole words, AND/OR/XOR/ANDNOT use AVX2
+//when iSimdScan.isa() allows it. Error codes are the VEC_ERR__* ones.
+typedef struct {
+	//live cycle, new bits are 0
+	BVec			(*construct)(size_t size);
+	BVec			(*construct_with_allocator)(size_t size, const AllocatorInterface* allocator);
+	BVec			(*copy)(const BVec v);
+	int32_t		(*destruct)(BVec v);
+
+	//info
+	size_t		(*size)(const BVec v);
+	size_t		(*capacity)(const BVec v);
+	uint32_t	(*error)(const BVec v);
+
+	//memory, sizes in bits
+	int32_t		(*reserve)(BVec v, size_t capacity);
+	int32_t		(*resize)(BVec v, size_t size);
+	int32_t		(*push_back)(BVec v, int bit);
+
+	//single bits, test returns 0/1 or an error
+	int32_t		(*set)(BVec v, size_t index);
+	int32_t		(*reset)(BVec v, size_t index);
+	int32_t		(*flip)(BVec v, size_t index);
+	int32_t		(*assign)(BVec v, size_t index, int bit);
+	int32_t		(*test)(const BVec v, size_t index);
+
+	//ranges and the whole vector
+	int32_t		(*assign_range)(BVec v, size_t begin_index, size_t end_index, int bit);
+	int32_t		(*fill)(BVec v, int bit);
+	int32_t		(*invert)(BVec v);
+
+	//bulk, dst op= src, both vectors must have the same size (VEC_ERR__DIFFERENT_TYPES)
+	int32_t		(*and_with)(BVec dst, const BVec src);
+	int32_t		(*or_with)(BVec dst, const BVec src);
+	int32_t		(*xor_with)(BVec dst, const BVec src);
+	//dst &= ~src
+	int32_t		(*andnot_with)(BVec dst, const BVec src);
+
+	//counting: rank - set bits in [0, index), select - index of the set bit with rank k,
+	//size if there are not that many. Both use samples rebuilt after a change
+	size_t		(*count)(const BVec v);
+	size_t		(*rank)(const BVec v, size_t index);
+	size_t		(*select)(const BVec v, size_t k);
+
+	//scans, size if there is no such bit
+	size_t		(*find_next)(const BVec v, size_t from);
+	size_t		(*find_next_zero)(const BVec v, size_t from);
+	//set bits in ascending order, a word at a time
+	int32_t		(*for_each_set)(const BVec v, void (*cb)(size_t index, void* extra), void* extra);
+
+	//raw words for custom kernels, writes through them must keep the bits past size 0
+	uint64_t*	(*words)(const BVec v, size_t* count);
+} BitVectorInterface;
+
+extern BitVectorInterface iBVec;
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef CONCURRENT_VECTOR_INTERFACE_H
+#define CONCURRENT_VECTOR_INTERFACE_H
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#define CVEC_OK															 0
+#define CVEC_ERR__NULL_VEC									-1
+#define CVEC_ERR__NULL_ELEM									-2
+#define CVEC_ERR__NULL_CALLBACK							-3
+#define CVEC_ERR__MALLOC										-4
+
+//segment k holds CVEC_FIRST_SEGMENT_SIZE << k elements, must be a power of two
+#ifndef CVEC_FIRST_SEGMENT_SIZE
+#define CVEC_FIRST_SEGMENT_SIZE							64
+#endif
+
+typedef struct tagConcurrentVector* CVec;
+
+//append-only vector for many producers: push, at, size and for_each are thread safe.
+//Elements live in segments that are never moved, so a pointer from at stays valid
+//until destruct. size counts published elements: every index below it is fully written.
+typedef struct {
+	CVec			(*construct)(size_t elem_size);
+	//no other thread may use cv anymore
+	void			(*destruct)(CVec cv);
+
+	//the slot is taken with one fetch-add, index (may be NULL) receives its position.
+	//If a segment can't be allocated the slot stays unpublished and the vector stops
+	//growing: every later push returns CVEC_ERR__MALLOC, reserve up front to avoid it
+	int32_t		(*push)(CVec cv, const void* elem, size_t* index);
+	//allocates the segments needed for capacity elements
+	int32_t		(*reserve)(CVec cv, size_t capacity);
+
+	//NULL - index is not published yet
+	void*			(*at)(const CVec cv, size_t index);
+	size_t		(*size)(const CVec cv);
+	size_t		(*elem_size)(const CVec cv);
+	//visits the elements published when the call starts
+	int32_t		(*for_each)(CVec cv, void (*cb)(void* elem, size_t index, void* extra), void* extra);
+} ConcurrentVectorInterface;
+
+extern ConcurrentVectorInterface iCVec;
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef CHUNKED_VECTOR_INTERFACE_H
+#define CHUNKED_VECTOR_INTERFACE_H
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#include "allocator_i.h"
+#include "vec_i.h"
+
+//block size used by construct, rounded down to a power of two elements (at least one)
+#ifndef DVEC_BLOCK_BYTES
+#define DVEC_BLOCK_BYTES										4096
+#endif
+
+#define DVEC_MIN_DIRECTORY									8
+
+typedef struct tagChunkedVector* DVec;
+
+//double ended vector of fixed-size blocks reached through a block directory.
+//Elements never move: pointers stay valid until the element is popped or the vector cleared.
+//Growing allocates one block, the directory (one pointer per block) is the only thing ever copied.
+//Error codes are the VEC_ERR__* ones.
+typedef struct {
+	//live cycle
+	DVec			(*construct)(size_t elem_size);
+	DVec			(*construct_with_allocator)(size_t elem_size, const AllocatorInterface* allocator);
+	//block_size in elements, rounded up to a power of two
+	DVec			(*construct_with_block_size)(size_t elem_size, size_t block_size);
+	int32_t		(*destruct)(DVec v);
+
+	//info
+	size_t		(*size)(const DVec v);
+	size_t		(*capacity)(const DVec v);
+	size_t		(*elem_size)(const DVec v);
+	size_t		(*block_size)(const DVec v);
+	uint32_t	(*error)(const DVec v);
+
+	//called on elements removed without being copied out
+	int32_t		(*set_elem_destructor)(DVec v, void (*cb)(void* elem));
+
+	//sizes the directory for capacity elements so pushes never copy it, blocks are allocated when reached
+	int32_t		(*reserve)(DVec v, size_t capacity);
+	//frees the cached spare block
+	int32_t		(*shrink_to_fit)(DVec v);
+
+	//ends, O(1)
+	int32_t		(*add)(DVec v, const void* elem);
+	int32_t		(*push_front)(DVec v, const void* elem);
+	//out == NULL - the element destructor is called
+	int32_t		(*pop_back)(DVec v, void* out);
+	int32_t		(*pop_front)(DVec v, void* out);
+	int32_t		(*clear)(DVec v);
+
+	//access, NULL - invalid index or empty vector
+	void*			(*at)(const DVec v, size_t index);
+	void*			(*front)(const DVec v);
+	void*			(*back)(const DVec v);
+	int32_t		(*for_each)(DVec v, void (*cb)(void* elem, size_t index, void* extra), void* extra);
+} ChunkedVectorInterface;
+
+extern ChunkedVectorInterface iDVec;
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef FILE_MAP_INTERFACE_H
+#define FILE_MAP_INTERFACE_H
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#define FILE_MAP_OK													 0
+#define FILE_MAP_ERR__NULL_MAP							-1
+#define FILE_MAP_ERR__READ_ONLY							-2
+#define FILE_MAP_ERR__RESIZE								-3
+#define FILE_MAP_ERR__MAP										-4
+#define FILE_MAP_ERR__FLUSH									-5
+
+//OPEN FLAGS
+#define FILE_MAP__READ											0
+#define FILE_MAP__WRITE											(1 << 0)
+#define FILE_MAP__CREATE										(1 << 1)		//create or truncate, implies WRITE
+
+typedef struct FileMap_t* FileMap;
+
+typedef struct {
+	//whole file is mapped shared, CREATE makes it length bytes long first
+	//pages are loaded on first access, so opening a big file costs nothing
+	FileMap		(*open)(const char* path, uint32_t flags, size_t length);
+	int32_t		(*close)(FileMap map);
+
+	void*			(*data)(const FileMap map);
+	size_t		(*length)(const FileMap map);
+	int32_t		(*writable)(const FileMap map);
+
+	//file and mapping change size together, data() may move
+	int32_t		(*resize)(FileMap map, size_t length);
+	//writes dirty pages back to the file
+	int32_t		(*flush)(FileMap map);
+} FileMapInterface_t;
+
+extern FileMapInterface_t iFileMap;
+
+#endif
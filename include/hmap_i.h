@@ -0,0 +1,70 @@
+#ifndef HASH_MAP_INTERFACE_H
+#define HASH_MAP_INTERFACE_H
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#include "allocator_i.h"
+
+#define HMAP_OK															 0
+#define HMAP_ERR__NULL_MAP									-1
+#define HMAP_ERR__NULL_KEY									-2
+#define HMAP_ERR__MALLOC										-3
+#define HMAP_ERR__KEY_NOT_FOUND							-4
+#define HMAP_ERR__NULL_CALLBACK							-5
+
+#define HMAP_MIN_CAPACITY										8
+
+typedef struct tagHashMap* HMap;
+
+//hash == NULL - iHMap.hash_bytes, eq == NULL - memcmp. eq returns non zero for equal keys
+typedef uint64_t	(*hmap_hash_fn)(const void* key, size_t key_size);
+typedef int				(*hmap_eq_fn)(const void* first, const void* second, size_t key_size);
+
+//iteration state, start from HMAP_ITER_INIT
+typedef struct {
+	size_t			index;
+	const void*	key;
+	void*				value;
+} hmap_iter_t;
+
+#define HMAP_ITER_INIT											{ 0, NULL, NULL }
+
+//flat open addressing with one control byte per slot (SwissTable layout): 7 bits of the
+//hash or empty/deleted, probed 8 slots at a time. Keys and values are copied into the slots,
+//value pointers stay valid until the next insert that grows the table or the key is removed.
+typedef struct {
+	//live cycle, value_size may be 0 for a set
+	HMap			(*construct)(size_t key_size, size_t value_size, hmap_hash_fn hash, hmap_eq_fn eq);
+	HMap			(*construct_with_allocator)(size_t key_size, size_t value_size, hmap_hash_fn hash, hmap_eq_fn eq, const AllocatorInterface* allocator);
+	int32_t		(*destruct)(HMap m);
+
+	//info
+	size_t		(*size)(const HMap m);
+	size_t		(*capacity)(const HMap m);
+	uint32_t	(*error)(const HMap m);
+
+	//memory, reserve makes room for count entries without rehashing
+	int32_t		(*reserve)(HMap m, size_t count);
+	int32_t		(*clear)(HMap m);
+
+	//1 - inserted, 0 - value of an existing key replaced, value == NULL - zeroed value
+	int32_t		(*put)(HMap m, const void* key, const void* value);
+	//value slot of key, a new key gets a zeroed value and inserted (may be NULL) is set to 1
+	void*			(*get_or_insert)(HMap m, const void* key, int32_t* inserted);
+	//NULL - no such key
+	void*			(*get)(const HMap m, const void* key);
+	int32_t		(*contains)(const HMap m, const void* key);
+	//out (may be NULL) receives the value
+	int32_t		(*remove)(HMap m, const void* key, void* out);
+
+	//1 - it holds the next entry, 0 - done. The map must not be changed while iterating
+	int32_t		(*next)(const HMap m, hmap_iter_t* it);
+	int32_t		(*for_each)(HMap m, void (*cb)(const void* key, void* value, void* extra), void* extra);
+
+	uint64_t	(*hash_bytes)(const void* key, size_t key_size);
+} HashMapInterface;
+
+extern HashMapInterface iHMap;
+
+#endif
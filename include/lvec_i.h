@@ -4,13 +4,23 @@
 #include <stdlib.h>
 #include <inttypes.h>
 
+#include "allocator_i.h"
+
 #define LVEC_START_CAPACITY					8
 #define	LVEC_REALLOC_SCALE_FACTOR		2
 
+//elements stored inside the LVec block by construct, 0 - data always on the heap
+#ifndef LVEC_INLINE_CAPACITY
+#define LVEC_INLINE_CAPACITY				0
+#endif
+
 typedef struct tagLightVector* LVec;
 
 typedef struct {
 	LVec 			(*construct)(size_t elem_size);
+	LVec 			(*construct_with_inline_capacity)(size_t elem_size, size_t inline_capacity);
+	//NULL - CurrentAllocator, used for all of the LVec's memory
+	LVec 			(*construct_with_allocator)(size_t elem_size, const AllocatorInterface* allocator);
 	void			(*destruct)(LVec lvec);
 	size_t 		(*size)(const LVec lvec);
 	size_t		(*elem_size)(const LVec lvec);
@@ -2,6 +2,7 @@
 #define OBSERVER_INTERFACE_H
 
 #include <inttypes.h>
+#include <stddef.h>
 #include <stdlib.h>
 
 #include "lvec_i.h"
@@ -11,15 +12,53 @@
 #define OBS_ERR__NULL_ACTION									-2
 #define OBS_ERR__NULL_CALLBACK								-3
 #define OBS_ERR__NULL_VEC											-4
+#define OBS_ERR__MALLOC												-5
+#define OBS_ERR__THREAD												-6
+#define OBS_ERR__ASYNC_RUNNING								-7
+#define OBS_ERR__DROPPED											-8
+#define OBS_ERR__IN_NOTIFY										-9
+
+//ASYNC FULL QUEUE POLICY
+#define OBS_ASYNC__BLOCK											0		//wait for a free slot
+#define OBS_ASYNC__DROP												1		//count and forget the event
+#define OBS_ASYNC__INLINE											2		//deliver on the notifying thread
+
+#define OBS_ASYNC_DEFAULT_CAPACITY						1024
+//bytes of the extra payload copied into a queue slot
+#define OBS_ASYNC_EXTRA_MAX										384
+//snapshot result: the extra can't be copied, deliver on the notifying thread after the queue
+#define OBS_SNAPSHOT_INLINE										((size_t)-1)
 
 typedef struct Observer_t* Observer;
 
+//snapshot copies extra into out (out_size bytes) and returns the bytes used,
+//0 - callbacks get the original extra pointer. A result above out_size is the size
+//needed: it is called again with a heap buffer that big, freed after delivery
+typedef struct {
+	size_t		capacity;		//queue slots, rounded up to a power of two, 0 - OBS_ASYNC_DEFAULT_CAPACITY
+	uint32_t	policy;			//OBS_ASYNC__*
+	size_t		(*snapshot)(int action, const void* extra, void* out, size_t out_size);
+} obs_async_config_t;
+
 typedef struct {
 	Observer	(*construct)(void);
 	void 			(*destruct)(Observer obs);
 	int32_t		(*subscribe)(Observer obs, uint64_t action_mask, void (*cb)(uint32_t action_flag, const void* call_extra, void* cb_extra), void* cb_extra, int auto_free_extra);
 	void*			(*unsubscribe)(Observer obs, uint64_t action_mask, void (*cb)(uint32_t action_flag, const void* call_extra, void* cb_extra));
 	int32_t		(*notify)(Observer obs, int action, void* extra);
+	//all calls are thread safe: notify reads a published subscriber snapshot without locks,
+	//(un)subscribe publish a new one. Blocks until every notify running at the time of
+	//the call has returned, so an extra returned by unsubscribe can be freed afterwards.
+	int32_t		(*synchronize)(Observer obs);
+
+	//async delivery: notify puts the action and an extra snapshot into a lock-free queue,
+	//a dispatcher thread runs the callbacks, stop delivers what is queued first
+	int32_t		(*start_async)(Observer obs, const obs_async_config_t* config);
+	int32_t		(*stop_async)(Observer obs);
+	//blocks until everything notified before the call is delivered. Called from a callback it
+	//delivers the queued events on the calling thread instead of waiting for the dispatcher
+	int32_t		(*flush)(Observer obs);
+	uint64_t	(*dropped)(const Observer obs);
 } ObserverInterface_t;
 
 extern ObserverInterface_t iObserver;
@@ -0,0 +1,37 @@
+#ifndef POOL_ALLOCATOR_INTERFACE_H
+#define POOL_ALLOCATOR_INTERFACE_H
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#include "allocator_i.h"
+
+//size classes are powers of two from POOL_MIN_BLOCK_SIZE to POOL_MAX_BLOCK_SIZE,
+//anything bigger goes straight to the system allocator
+#define POOL_MIN_BLOCK_SHIFT								4
+#define POOL_MAX_BLOCK_SHIFT								10
+#define POOL_MIN_BLOCK_SIZE									(1 << POOL_MIN_BLOCK_SHIFT)
+#define POOL_MAX_BLOCK_SIZE									(1 << POOL_MAX_BLOCK_SHIFT)
+#define POOL_CLASS_COUNT										(POOL_MAX_BLOCK_SHIFT - POOL_MIN_BLOCK_SHIFT + 1)
+
+#define POOL_SLAB_SIZE											(64 * 1024)
+#define POOL_THREAD_CACHE_LIMIT							256
+#define POOL_BATCH_SIZE											32
+
+typedef struct {
+	size_t	cached_blocks[POOL_CLASS_COUNT];
+	size_t	slab_bytes;
+} pool_thread_stats_t;
+
+typedef struct {
+	size_t	(*block_size)(size_t size);
+	void		(*flush_thread_cache)(void);
+	void		(*thread_stats)(pool_thread_stats_t* stats);
+} PoolInterface_t;
+
+extern PoolInterface_t iPool;
+
+//small blocks come from per-thread free lists, large ones from DefaultAllocator
+extern AllocatorInterface PoolAllocator;
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef PARALLEL_SORT_INTERFACE_H
+#define PARALLEL_SORT_INTERFACE_H
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#define PSORT_OK														 0
+#define PSORT_ERR__MALLOC										-1
+#define PSORT_ERR__NULL_CMP_FN							-3
+#define PSORT_ERR__NULL_DATA								-4
+
+//arrays shorter than this are sorted on the calling thread
+#define PSORT_DEFAULT_CUTOFF								(1 << 16)
+#define PSORT_MAX_THREADS										64
+
+typedef struct {
+	size_t	threads;		//0 - one per hardware thread
+	size_t	cutoff;			//0 - PSORT_DEFAULT_CUTOFF
+	int			stable;			//keep the order of equal elements
+} psort_config_t;
+
+typedef struct {
+	//sorts base in place by cmp: chunks are sorted in parallel, then merged pairwise
+	//with every merge split between threads, config == NULL uses the defaults
+	int32_t	(*sort)(void* base, size_t count, size_t elem_size, int32_t (*cmp)(const void* first, const void* second), const psort_config_t* config);
+	size_t	(*hardware_threads)(void);
+} PSortInterface_t;
+
+extern PSortInterface_t iPSort;
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef RING_BUFFER_INTERFACE_H
+#define RING_BUFFER_INTERFACE_H
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#include "allocator_i.h"
+#include "observer_i.h"
+
+#define RING_OK															 0
+#define RING_ERR__NULL_RING									-1
+#define RING_ERR__NULL_ELEM									-2
+#define RING_ERR__FULL											-3
+#define RING_ERR__EMPTY											-4
+#define RING_ERR__MALLOC										-5
+#define RING_ERR__MODE											-6
+#define RING_ERR__OBSERVER_CONSTRUCT				-7
+
+//FLAGS, fixed at construct
+//one producer thread (push_back, push_n) and one consumer thread (pop_front, pop_n, peek_n, consume)
+//without locks, the other calls are not allowed or not thread safe in this mode
+#define RING_FLAG__SPSC											(1 << 0)
+//push into a full ring drops the oldest element (the back one for push_front), not with SPSC
+#define RING_FLAG__OVERWRITE								(1 << 1)
+
+//ACTIONS, extra is ring_action_extra_t
+#define RING_ACTION__PUSH										(1 << 0)
+#define RING_ACTION__POP										(1 << 1)
+#define RING_ACTION__OVERWRITE							(1 << 2)
+#define RING_ACTION__CLEAR									(1 << 3)
+#define RING_ACTION__DESTRUCT								(1 << 4)
+
+typedef struct tagRingBuffer* Ring;
+
+typedef struct {
+	void*		data;
+	size_t	count;
+} ring_span_t;
+
+//elements wrapping around the end of the buffer take a second span
+typedef struct {
+	ring_span_t	first;
+	ring_span_t	second;
+} ring_spans_t;
+
+//spans hold the pushed, popped or dropped elements, in the buffer, while callbacks run
+typedef struct {
+	Ring					ring;
+	size_t				count;
+	ring_spans_t	spans;
+} ring_action_extra_t;
+
+//capacity is rounded up to a power of two, the element destructor runs on elements
+//leaving the ring without being copied out: pops with out == NULL, consume, clear,
+//overwrite and destruct
+typedef struct {
+	//live cycle
+	Ring			(*construct)(size_t elem_size, size_t capacity, uint32_t flags);
+	Ring			(*construct_with_allocator)(size_t elem_size, size_t capacity, uint32_t flags, const AllocatorInterface* allocator);
+	int32_t		(*destruct)(Ring r);
+
+	//info
+	size_t		(*size)(const Ring r);
+	size_t		(*capacity)(const Ring r);
+	size_t		(*elem_size)(const Ring r);
+	uint32_t	(*get_flags)(const Ring r);
+	uint32_t	(*error)(const Ring r);
+	int32_t		(*set_elem_destructor)(Ring r, void (*cb)(void* elem));
+
+	//single elements, O(1)
+	int32_t		(*push_back)(Ring r, const void* elem);
+	int32_t		(*push_front)(Ring r, const void* elem);
+	int32_t		(*pop_front)(Ring r, void* out);
+	int32_t		(*pop_back)(Ring r, void* out);
+	int32_t		(*clear)(Ring r);
+
+	//bulk, return the number of elements moved. spans (may be NULL) receive where the
+	//elements are in the buffer: pushed ones, popped ones until the next push.
+	//pop_n with dst == NULL and spans != NULL hands the elements over without the destructor.
+	//With SPSC pop_n takes no spans (RING_ERR__MODE): the producer may overwrite popped
+	//slots at once, peek_n and consume are the zero copy path there
+	size_t		(*push_n)(Ring r, const void* src, size_t count, ring_spans_t* spans);
+	size_t		(*pop_n)(Ring r, void* dst, size_t count, ring_spans_t* spans);
+
+	//zero copy read: the first count elements stay in place until consume releases them,
+	//the way to read without copying in SPSC mode
+	size_t		(*peek_n)(const Ring r, size_t count, ring_spans_t* spans);
+	size_t		(*consume)(Ring r, size_t count);
+
+	//access from the front, NULL - invalid index
+	void*			(*at)(const Ring r, size_t index);
+
+	//observers
+	int32_t		(*subscribe)(Ring r, uint64_t action_mask, void (*cb)(uint32_t action_flag, const void* call_extra, void* cb_extra), void* cb_extra, int auto_free_extra);
+	void*			(*unsubscribe)(Ring r, uint64_t action_mask, void (*cb)(uint32_t action_flag, const void* call_extra, void* cb_extra));
+} RingBufferInterface;
+
+extern RingBufferInterface iRing;
+
+#endif
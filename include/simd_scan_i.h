@@ -0,0 +1,27 @@
+#ifndef SIMD_SCAN_INTERFACE_H
+#define SIMD_SCAN_INTERFACE_H
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#define SIMD_ISA__SCALAR										0
+#define SIMD_ISA__SSE2											1
+#define SIMD_ISA__AVX2											2
+
+//bytewise equality scans over arrays of 1, 2, 4 or 8 byte elements,
+//kernels are picked on first use by cpu feature detection
+typedef struct {
+	//index of the first match at or after start, count if there is none
+	size_t			(*find)(const void* data, size_t count, size_t width, const void* value, size_t start);
+	size_t			(*count_equal)(const void* data, size_t count, size_t width, const void* value);
+	//writes indices of all matches to out, which must hold count_equal() entries
+	size_t			(*find_all)(const void* data, size_t count, size_t width, const void* value, size_t* out);
+
+	uint32_t		(*isa)(void);
+	//limits kernels to isa or below (never above what the cpu supports), returns the active one
+	uint32_t		(*set_isa)(uint32_t isa);
+} SimdScanInterface_t;
+
+extern SimdScanInterface_t iSimdScan;
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef SOA_VECTOR_INTERFACE_H
+#define SOA_VECTOR_INTERFACE_H
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#include "allocator_i.h"
+#include "vec_i.h"
+
+//column alignment used when the schema leaves it 0, must be a power of two
+#ifndef SVEC_COLUMN_ALIGN
+#define SVEC_COLUMN_ALIGN										64
+#endif
+
+typedef struct tagSoAVector* SVec;
+
+//sizes[i] - bytes of field i. A record passed to add/insert/replace or read by get holds
+//field i at offsets[i] (NULL - fields packed back to back) and takes record_size bytes
+//(0 - end of the last field), so a plain C struct can be used with offsetof
+typedef struct {
+	const size_t*	sizes;
+	const size_t*	offsets;
+	size_t				count;
+	size_t				record_size;
+	size_t				align;			//column start alignment, 0 - SVEC_COLUMN_ALIGN
+} svec_schema_t;
+
+//elements [0, count) of one field, contiguous and elem_size apart
+typedef struct {
+	void*		data;
+	size_t	count;
+	size_t	elem_size;
+} svec_span_t;
+
+//struct of arrays: field i of every record is stored in its own contiguous column, so a pass
+//over one field reads only that field. Column pointers stay valid until the vector grows.
+//Error codes are the VEC_ERR__* ones, a bad field number is VEC_ERR__INVALID_INDEX.
+typedef struct {
+	//live cycle
+	SVec			(*construct)(const size_t* field_sizes, size_t field_count);
+	SVec			(*construct_with_schema)(const svec_schema_t* schema, const AllocatorInterface* allocator);
+	int32_t		(*destruct)(SVec v);
+
+	//info
+	size_t		(*size)(const SVec v);
+	size_t		(*capacity)(const SVec v);
+	size_t		(*field_count)(const SVec v);
+	size_t		(*field_size)(const SVec v, size_t field);
+	size_t		(*record_size)(const SVec v);
+	uint32_t	(*error)(const SVec v);
+
+	//cmp receives two values of the key field
+	int32_t		(*set_compare_fn)(SVec v, size_t field, int32_t (*cmp)(const void* first, const void* second));
+
+	//memory
+	int32_t		(*reserve)(SVec v, size_t capacity);
+	int32_t		(*shrink_to_fit)(SVec v);
+
+	//records are scattered into the columns
+	int32_t		(*add)(SVec v, const void* record);
+	int32_t		(*add_range)(SVec v, const void* records, size_t count);
+	int32_t		(*insert_at)(SVec v, size_t index, const void* record);
+	int32_t		(*replace_at)(SVec v, size_t index, const void* record);
+
+	int32_t		(*clear)(SVec v);
+	int32_t		(*erase_at)(SVec v, size_t index);
+	int32_t		(*erase_range)(SVec v, size_t begin_index, size_t end_index);
+
+	//access: at gathers a record into out, field_at points into a column
+	int32_t		(*at)(const SVec v, size_t index, void* out);
+	void*			(*field_at)(const SVec v, size_t field, size_t index);
+	//fields[i] points to field i of the record
+	int32_t		(*for_each)(SVec v, void (*cb)(void* const* fields, size_t index, void* extra), void* extra);
+
+	//columns, for kernels streaming one field
+	int32_t		(*column)(const SVec v, size_t field, svec_span_t* out);
+	int32_t		(*column_range)(const SVec v, size_t field, size_t begin_index, size_t end_index, svec_span_t* out);
+
+	//stable sort of whole records by the key field: keys are sorted with iPSort, then every
+	//column is permuted once
+	int32_t		(*sort)(SVec v);
+} SoAVectorInterface;
+
+extern SoAVectorInterface iSVec;
+
+#endif
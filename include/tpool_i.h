@@ -0,0 +1,40 @@
+#ifndef THREAD_POOL_INTERFACE_H
+#define THREAD_POOL_INTERFACE_H
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#define TPOOL_OK														 0
+#define TPOOL_ERR__NULL_POOL								-1
+#define TPOOL_ERR__NULL_TASK								-2
+#define TPOOL_ERR__MALLOC										-3
+#define TPOOL_ERR__STOPPED									-4
+
+#define TPOOL_MAX_THREADS										64
+#define TPOOL_DEQUE_START_CAPACITY					64
+
+typedef struct ThreadPool_t* ThreadPool;
+
+typedef struct {
+	//live cycle, threads == 0 - one worker per hardware thread
+	ThreadPool	(*construct)(size_t threads);
+	void				(*destruct)(ThreadPool pool);
+	//shared pool, created on first use and destructed by atexit, don't destruct it yourself
+	ThreadPool	(*default_pool)(void);
+
+	//tasks go to per-worker deques, idle workers steal from the others
+	int32_t			(*submit)(ThreadPool pool, void (*task)(void* arg), void* arg);
+	//blocks until every submitted task has finished
+	void				(*wait)(ThreadPool pool);
+
+	//runs body over [0, count) in chunks of grain elements and returns when all are done,
+	//the calling thread runs queued tasks while it waits so nested calls don't deadlock
+	int32_t			(*parallel_for)(ThreadPool pool, size_t count, size_t grain, void (*body)(size_t begin, size_t end, void* arg), void* arg);
+
+	size_t			(*threads)(const ThreadPool pool);
+	size_t			(*hardware_threads)(void);
+} ThreadPoolInterface_t;
+
+extern ThreadPoolInterface_t iThreadPool;
+
+#endif
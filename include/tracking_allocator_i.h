@@ -0,0 +1,59 @@
+#ifndef TRACKING_ALLOCATOR_INTERFACE_H
+#define TRACKING_ALLOCATOR_INTERFACE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <inttypes.h>
+
+#include "allocator_i.h"
+
+//histogram bucket i counts requests of [2^i, 2^(i+1)) bytes
+#define TRACKER_HISTOGRAM_BUCKETS						32
+#define TRACKER_MAX_CALL_SITES							64
+
+typedef struct Tracker_t* Tracker;
+
+typedef struct {
+	size_t	malloc_calls;
+	size_t	realloc_calls;
+	size_t	calloc_calls;
+	size_t	free_calls;
+	size_t	failed_calls;
+	size_t	live_bytes;
+	size_t	peak_bytes;
+	size_t	total_bytes;
+	size_t	size_histogram[TRACKER_HISTOGRAM_BUCKETS];
+} tracker_stats_t;
+
+//call site is the return address of the allocator call, NULL collects overflow
+typedef struct {
+	const void*	address;
+	size_t			calls;
+	size_t			realloc_calls;
+	size_t			bytes;
+} tracker_call_site_t;
+
+typedef struct {
+	//live cycle, inner == NULL wraps CurrentAllocator. Blocks may outlive destruct: the
+	//tracker is released by the free of its last block, its stats can't be read anymore
+	Tracker							(*construct)(const AllocatorInterface* inner);
+	void								(*destruct)(Tracker tracker);
+
+	//binding: TrackingAllocator reports to the tracker bound to the calling thread
+	AllocatorInterface*	(*bind)(Tracker tracker);
+	Tracker							(*current)(void);
+
+	//query
+	void								(*stats)(const Tracker tracker, tracker_stats_t* stats);
+	size_t							(*call_sites)(const Tracker tracker, tracker_call_site_t* sites, size_t max_sites);
+	void								(*reset_stats)(Tracker tracker);
+	void								(*dump)(const Tracker tracker, FILE* out);
+} TrackerInterface_t;
+
+extern TrackerInterface_t iTracker;
+
+//forwards to the inner allocator of the bound tracker and counts every call,
+//a tracker isn't synchronized so bind each one to a single thread
+extern AllocatorInterface TrackingAllocator;
+
+#endif
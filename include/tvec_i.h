@@ -0,0 +1,196 @@
+#ifndef TYPED_VECTOR_INTERFACE_H
+#define TYPED_VECTOR_INTERFACE_H
+
+#include <stddef.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "allocator_i.h"
+#include "vec_i.h"
+
+//ranges shorter than this are finished by insertion sort
+#define TVEC_INSERTION_SORT_THRESHOLD				16
+
+//VEC_DEFINE(name, T) emits a typed vector `name` and static inline functions
+//name_init, name_destroy, name_size, name_capacity, name_reserve, name_add,
+//name_at, name_insert, name_erase_at, name_clear, name_sort, name_find and
+//name_for_each. Elements are copied by assignment and compare/callback
+//pointers passed as constants can be inlined by the compiler.
+//Error codes are the VEC_ERR__* ones. Use Vec when observers are needed.
+#define VEC_DEFINE(name, T)																																	\
+																																													\
+typedef struct {																																					\
+	size_t										size;																													\
+	size_t										capacity;																											\
+	T*												data;																													\
+	const AllocatorInterface*	allocator;																										\
+} name;																																										\
+																																													\
+static inline void name##_init(name* v, const AllocatorInterface* allocator) {							\
+	v->size = 0;																																						\
+	v->capacity = 0;																																				\
+	v->data = NULL;																																					\
+	v->allocator = allocator != NULL ? allocator : CurrentAllocator;												\
+}																																													\
+																																													\
+static inline void name##_destroy(name* v) {																								\
+	if (v->data != NULL) {																																	\
+		v->allocator->free(v->data);																													\
+	}																																												\
+	v->data = NULL;																																					\
+	v->size = 0;																																						\
+	v->capacity = 0;																																				\
+}																																													\
+																																													\
+static inline size_t name##_size(const name* v) {																						\
+	return v->size;																																					\
+}																																													\
+																																													\
+static inline size_t name##_capacity(const name* v) {																				\
+	return v->capacity;																																			\
+}																																													\
+																																													\
+static inline int32_t name##_reserve(name* v, size_t capacity) {														\
+	if (capacity <= v->capacity) {																													\
+		return VEC_OK;																																				\
+	}																																												\
+	if (capacity < VEC_MIN_SIZE) {																													\
+		capacity = VEC_MIN_SIZE;																															\
+	}																																												\
+	T* tmp = v->allocator->realloc(v->data, capacity * sizeof(T));													\
+	if (tmp == NULL) {																																			\
+		return VEC_ERR__REALLOC;																															\
+	}																																												\
+	v->data = tmp;																																					\
+	v->capacity = capacity;																																	\
+	return VEC_OK;																																					\
+}																																													\
+																																													\
+static inline int32_t name##_grow(name* v) {																								\
+	return name##_reserve(v, v->capacity == 0 ? VEC_MIN_SIZE : v->capacity * VEC_REALLOC_SCALE_FACTOR);	\
+}																																													\
+																																													\
+static inline int32_t name##_add(name* v, T elem) {																					\
+	if (v->size == v->capacity) {																														\
+		int32_t res = name##_grow(v);																													\
+		if (res < 0) {																																				\
+			return res;																																					\
+		}																																											\
+	}																																												\
+	v->data[v->size++] = elem;																															\
+	return VEC_OK;																																					\
+}																																													\
+																																													\
+static inline T* name##_at(const name* v, size_t index) {																		\
+	return index < v->size ? &v->data[index] : NULL;																				\
+}																																													\
+																																													\
+static inline int32_t name##_insert(name* v, size_t index, T elem) {												\
+	if (index > v->size) {																																	\
+		return VEC_ERR__INVALID_INDEX;																												\
+	}																																												\
+	if (v->size == v->capacity) {																														\
+		int32_t res = name##_grow(v);																													\
+		if (res < 0) {																																				\
+			return res;																																					\
+		}																																											\
+	}																																												\
+	memmove(&v->data[index + 1], &v->data[index], (v->size - index) * sizeof(T));						\
+	v->data[index] = elem;																																	\
+	v->size++;																																							\
+	return VEC_OK;																																					\
+}																																													\
+																																													\
+static inline int32_t name##_erase_at(name* v, size_t index) {															\
+	if (index >= v->size) {																																	\
+		return VEC_ERR__INVALID_INDEX;																												\
+	}																																												\
+	memmove(&v->data[index], &v->data[index + 1], (v->size - index - 1) * sizeof(T));				\
+	v->size--;																																							\
+	return VEC_OK;																																					\
+}																																													\
+																																													\
+static inline void name##_clear(name* v) {																									\
+	v->size = 0;																																						\
+}																																													\
+																																													\
+static inline void name##_insertion_sort(T* data, size_t count, int (*cmp)(const T*, const T*)) {	\
+	for (size_t i = 1; i < count; i++) {																										\
+		T tmp = data[i];																																			\
+		size_t j = i;																																					\
+		for (; j > 0 && cmp(&tmp, &data[j - 1]) < 0; j--) {																		\
+			data[j] = data[j - 1];																															\
+		}																																											\
+		data[j] = tmp;																																				\
+	}																																												\
+}																																													\
+																																													\
+static inline void name##_quick_sort(T* data, size_t count, int (*cmp)(const T*, const T*)) {	\
+	while (count > TVEC_INSERTION_SORT_THRESHOLD) {																					\
+		/* median of three goes to data[0] and becomes the pivot */														\
+		size_t mid = count / 2;																																\
+		T tmp;																																								\
+		if (cmp(&data[mid], &data[0]) < 0) { tmp = data[mid]; data[mid] = data[0]; data[0] = tmp; }	\
+		if (cmp(&data[count - 1], &data[0]) < 0) { tmp = data[count - 1]; data[count - 1] = data[0]; data[0] = tmp; }	\
+		if (cmp(&data[count - 1], &data[mid]) < 0) { tmp = data[count - 1]; data[count - 1] = data[mid]; data[mid] = tmp; }	\
+		tmp = data[mid]; data[mid] = data[0]; data[0] = tmp;																	\
+																																													\
+		T pivot = data[0];																																		\
+		size_t i = 0;																																					\
+		size_t j = count;																																			\
+		for (;;) {																																						\
+			do { i++; } while (i < count && cmp(&data[i], &pivot) < 0);													\
+			do { j--; } while (cmp(&pivot, &data[j]) < 0);																			\
+			if (i >= j) {																																				\
+				break;																																						\
+			}																																										\
+			tmp = data[i]; data[i] = data[j]; data[j] = tmp;																		\
+		}																																											\
+		data[0] = data[j];																																		\
+		data[j] = pivot;																																			\
+																																													\
+		/* recurse into the smaller side, loop on the bigger one */														\
+		if (j < count - j - 1) {																															\
+			name##_quick_sort(data, j, cmp);																										\
+			data += j + 1;																																			\
+			count -= j + 1;																																			\
+		}																																											\
+		else {																																								\
+			name##_quick_sort(data + j + 1, count - j - 1, cmp);																\
+			count = j;																																					\
+		}																																											\
+	}																																												\
+	name##_insertion_sort(data, count, cmp);																								\
+}																																													\
+																																													\
+static inline int32_t name##_sort(name* v, int (*cmp)(const T*, const T*)) {								\
+	if (cmp == NULL) {																																			\
+		return VEC_ERR__NULL_CMP_FN;																													\
+	}																																												\
+	name##_quick_sort(v->data, v->size, cmp);																								\
+	return VEC_OK;																																					\
+}																																													\
+																																													\
+static inline T* name##_find(const name* v, const T* elem, int (*cmp)(const T*, const T*)) {	\
+	if (cmp == NULL) {																																			\
+		return NULL;																																					\
+	}																																												\
+	for (size_t i = 0; i < v->size; i++) {																									\
+		if (cmp(&v->data[i], elem) == 0) {																										\
+			return &v->data[i];																																	\
+		}																																											\
+	}																																												\
+	return NULL;																																						\
+}																																													\
+																																													\
+static inline int32_t name##_for_each(name* v, void (*cb)(T* elem, size_t index, void* extra), void* extra) {	\
+	if (cb == NULL) {																																				\
+		return VEC_ERR__NULL_CALLBACK;																												\
+	}																																												\
+	for (size_t i = 0; i < v->size; i++) {																									\
+		cb(&v->data[i], i, extra);																														\
+	}																																												\
+	return VEC_OK;																																					\
+}
+
+#endif
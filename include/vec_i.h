@@ -4,10 +4,22 @@
 #include <stddef.h>
 #include <inttypes.h>
 #include <allocator_i.h>
+#include <psort_i.h>
+#include <observer_i.h>
+#include <hmap_i.h>
 
 #define VEC_MIN_SIZE												 10
 #define VEC_REALLOC_SCALE_FACTOR						 2
 
+//elements stored inside the Vec block by construct, 0 - data always on the heap
+#ifndef VEC_INLINE_CAPACITY
+#define VEC_INLINE_CAPACITY									 0
+#endif
+
+//parallel algorithms: default grain is size / (threads * CHUNKS_PER_THREAD)
+#define VEC_PAR_CHUNKS_PER_THREAD						 4
+#define VEC_PAR_MIN_GRAIN										 1024
+
 #define VEC_OK															 0
 #define VEC_ERR__MALLOC											-1
 #define VEC_ERR__REALLOC										-2
@@ -27,12 +39,52 @@
 #define VEC_ERR__OBSERVER_CONSTRUCT  				-23
 #define VEC_ERR__VECTOR_CONSTRUCT  					-24
 #define VEC_ERR__ORDERED_MODE		  					-25
+#define VEC_ERR__NOT_ORDERED								-26
+#define VEC_ERR__INVALID_KEY								-27
+#define VEC_ERR__UNSUPPORTED_ELEM_SIZE			-28
+#define VEC_ERR__READ_ONLY									-29
+#define VEC_ERR__FILE_MAP										-30
+#define VEC_ERR__IO													-31
+#define VEC_ERR__BAD_FORMAT									-32
+#define VEC_ERR__CHECKSUM										-33
+#define VEC_ERR__NO_BATCH										-34
+#define VEC_ERR__ASYNC_INDEX								-35
+#define VEC_ERR__NO_INDEX										-36
+#define VEC_ERR__SHARED											-37
 
 //FLAGS
 #define VEC_FLAG__STATIC										(1 << 0)
 #define VEC_FLAG__OBSERVED	    						(1 << 1)
 #define VEC_FLAG__RECURSIVE_DESTRUCTION			(1 << 2)
 #define VEC_FLAG__ORDERED										(1 << 3)
+#define VEC_FLAG__PARALLEL_SORT							(1 << 4)
+#define VEC_FLAG__STABLE_SORT								(1 << 5)
+#define VEC_FLAG__RADIX_SORT								(1 << 6)
+#define VEC_FLAG__MAPPED										(1 << 7)
+#define VEC_FLAG__ASYNC_NOTIFY							(1 << 8)
+
+//SAVE OPTIONS
+#define VEC_SAVE__CHECKSUMS									(1 << 0)
+
+//save/load move the payload in chunks of this size
+#define VEC_IO_CHUNK_SIZE										(1 << 22)
+
+//dirty ranges kept per batch, more are merged into one
+#define VEC_BATCH_MAX_RANGES								16
+
+//FILE MAPPING MODES
+#define VEC_MAP__READ_ONLY									0
+#define VEC_MAP__READ_WRITE									(1 << 0)
+#define VEC_MAP__CREATE											(1 << 1)
+
+//RADIX KEYS
+#define VEC_KEY__NONE												0
+#define VEC_KEY__U32												1
+#define VEC_KEY__I32												2
+#define VEC_KEY__U64												3
+#define VEC_KEY__I64												4
+#define VEC_KEY__F32												5
+#define VEC_KEY__F64												6
 
 //ACTIONS
 #define VEC_ACTION__MAKE_ORDERED						(1 << 0)
@@ -54,12 +106,27 @@
 #define VEC_ACTION__SLICE										(1 << 13)
 #define VEC_ACTION__RELEASE_DATA						(1 << 14)
 
+#define VEC_ACTION__INSERT_RANGE						(1 << 15)
+#define VEC_ACTION__ERASE_RANGE							(1 << 16)
+#define VEC_ACTION__ERASE_IF								(1 << 17)
+
+//sent by commit_batch instead of the recorded mutations
+#define VEC_ACTION__BATCH										(1 << 18)
+
 //ACTION GROUPS
-#define VEC_ACTION__ADDITION				(VEC_ACTION__APPEND | VEC_ACTION__ADD | VEC_ACTION__INSERT)
-#define VEC_ACTION__REMOVING				(VEC_ACTION__DESTRUCT | VEC_ACTION__ERASE | VEC_ACTION__CLEAR | VEC_ACTION__REPLACE)
+#define VEC_ACTION__ADDITION				(VEC_ACTION__APPEND | VEC_ACTION__ADD | VEC_ACTION__INSERT | VEC_ACTION__INSERT_RANGE)
+#define VEC_ACTION__REMOVING				(VEC_ACTION__DESTRUCT | VEC_ACTION__ERASE | VEC_ACTION__CLEAR | VEC_ACTION__REPLACE | VEC_ACTION__ERASE_RANGE | VEC_ACTION__ERASE_IF)
 
 typedef struct tagVector* Vec;
 
+//non owning window into a Vec, invalidated by any change of the parent
+typedef struct {
+	Vec					parent;
+	const char*	data;
+	size_t			size;
+	size_t			elem_size;
+} vec_view_t;
+
 //ACTION DATA
 typedef struct {
 	Vec vector;
@@ -103,17 +170,66 @@ typedef struct {
 	void* elem;
 } replace_action_extra_t;
 
+typedef struct {
+	Vec vector;
+	void* pos;
+	const void* elems;
+	size_t count;
+} insert_range_action_extra_t;
+
+typedef struct {
+	Vec vector;
+	void* first;
+	void* last;
+	size_t count;
+} erase_range_action_extra_t;
+
+typedef struct {
+	Vec vector;
+	int (*pred)(const void* elem, size_t index, void* extra);
+	void* extra;
+} erase_if_action_extra_t;
+
+//[first, last) element indices
+typedef struct {
+	size_t first;
+	size_t last;
+} vec_range_t;
+
+//ranges: indices of the committed vector whose elements may have changed
+typedef struct {
+	Vec vector;
+	uint64_t actions;
+	size_t operations;
+	size_t added;
+	size_t removed;
+	const vec_range_t* ranges;
+	size_t range_count;
+} batch_action_extra_t;
+
 typedef struct {
 	//live cycle Vec
 	Vec 			(*construct)(size_t elem_size);
 	Vec 			(*construct_from_data)(size_t elem_size, void* data, size_t data_size);
-	Vec				(*construct_with_allocator)(size_t elem_size, const AllocatorInterface allocator);
+	Vec				(*construct_with_allocator)(size_t elem_size, const AllocatorInterface* allocator);
+	Vec				(*construct_with_inline_capacity)(size_t elem_size, size_t inline_capacity);
 	int32_t		(*destruct)(Vec v);
+
+	//file backed Vec, data is the mapped file and stays there on destruct
+	Vec				(*construct_mapped)(size_t elem_size, const char* path, uint32_t mode);
+	int32_t		(*flush)(Vec v);
 	
-	//new vector from this
+	//new vector from this, copy shares the data until one side is modified
 	Vec 			(*copy)(const Vec v);
 	Vec				(*filter)(const Vec v, int (*cb)(const void* elem, size_t index, void* extra), void* extra);
 	Vec				(*slice)(const Vec v, size_t begin_index, size_t end_index);
+	int32_t		(*is_shared)(const Vec v);
+
+	//views, no allocation and no copy
+	int32_t		(*view)(const Vec v, size_t begin_index, size_t end_index, vec_view_t* out);
+	int32_t		(*subview)(const vec_view_t* view, size_t begin_index, size_t end_index, vec_view_t* out);
+	const void*	(*view_at)(const vec_view_t* view, size_t index);
+	Vec				(*view_to_vec)(const vec_view_t* view);
 
 	//state
 	size_t 		(*size)(const Vec v);
@@ -131,6 +247,7 @@ typedef struct {
 
 	//other
 	int32_t		(*set_compare_fn)(Vec v, int32_t (*cmp)(const void* first, const void* second));
+	//VEC_ERR__SHARED while a copy shares the buffer
 	int32_t		(*set_elem_destructor)(Vec v, void (*cb)(void* elem));
 	void*			(*release_data)(Vec v);
 	void*			(*get_data_copy)(Vec v);
@@ -142,12 +259,16 @@ typedef struct {
 	//addition
 	int32_t 	(*add)(Vec v, void* elem);
 	int32_t 	(*insert)(Vec v, void* pos, void* elem);
+	//src may point into v itself, the range must then lie within size
+	int32_t		(*insert_range)(Vec v, void* pos, const void* src, size_t count);
 	int32_t		(*append)(Vec v, const Vec other);
 	
 	//removing
 	int32_t		(*clear)(Vec v);
 	int32_t		(*erase)(Vec v, void* pos);
 	int32_t		(*erase_at)(Vec v, size_t index);
+	int32_t		(*erase_range)(Vec v, void* first, void* last);
+	int32_t		(*erase_if)(Vec v, int (*pred)(const void* elem, size_t index, void* extra), void* extra);
 
 	//access
 	void*			(*at)(const Vec v, size_t index);
@@ -156,17 +277,61 @@ typedef struct {
 	void*			(*back)(const Vec v);
 	void*			(*next)(const Vec v, void* elem);
 	int32_t		(*for_each)(Vec v, void (*cb)(void* elem, size_t index, void* extra), void* extra);
-	int32_t		(*find)(const Vec v, void* elem, int (*cmp)(void* first, void* second));
+	int32_t		(*par_for_each)(Vec v, void (*cb)(void* elem, size_t index, void* extra), void* extra, size_t grain);
+	int32_t		(*par_reduce)(const Vec v, void* init, void (*combine)(void* acc, const void* elem, void* extra), void* extra);
+	Vec				(*par_filter)(const Vec v, int (*cb)(const void* elem, size_t index, void* extra), void* extra, size_t grain);
+	void*			(*find)(const Vec v, void* elem, int (*cmp)(void* first, void* second));
+
+	//ordered search, binary search by cmp_fn
+	void*			(*lower_bound)(const Vec v, const void* elem);
+	void*			(*upper_bound)(const Vec v, const void* elem);
+	int32_t		(*equal_range)(const Vec v, const void* elem, void** first, void** last);
+	int32_t		(*contains)(const Vec v, const void* elem);
+
+	//bytewise equality scans (SIMD), elem_size must be 1, 2, 4 or 8
+	void*			(*find_bytes)(const Vec v, const void* elem);
+	int64_t		(*count_equal)(const Vec v, const void* elem);
+	Vec				(*find_all_indices)(const Vec v, const void* elem);
 
 	//modification
 	int32_t 	(*replace)(Vec v, void* pos, void* elem);
 	int32_t 	(*replace_at)(Vec v, size_t index, void* elem);
 	int32_t		(*sort)(Vec v);
+	int32_t		(*par_sort)(Vec v, const psort_config_t* config);
+	int32_t		(*radix_sort)(Vec v, uint32_t key_type, size_t key_offset);
+	int32_t		(*set_radix_key)(Vec v, uint32_t key_type, size_t key_offset);
+
+	//serialization to a file descriptor, load restores flags, cmp_fn has to be set again
+	int32_t		(*save)(const Vec v, int fd, uint32_t options);
+	Vec				(*load)(int fd, int32_t* error);
 
 	//notification
 	int32_t		(*subscribe)(Vec v, uint64_t action_mask, void (*cb)(uint64_t action_flag, const void* calling_extra, void* cb_extra), void* cb_extra, int auto_free_extra);
 	void*			(*unsubscribe)(Vec v, uint64_t action_mask, void (*cb)(uint64_t action_flag, const void* calling_extra, void* cb_extra));
 
+	//mutations between begin and commit reach subscribers as one VEC_ACTION__BATCH event
+	int32_t		(*begin_batch)(Vec v);
+	int32_t		(*commit_batch)(Vec v);
+
+	//subscribers run on a dispatcher thread, extras are snapshots (elements included):
+	//erase/replace pos point to copies of the removed elements, insert pos is only a marker.
+	//actions whose extra is a Vec (APPEND, ERASE_IF, FILTER, SLICE, SORT, CLEAR, DESTRUCT, COPY,
+	//MAKE_*, RELEASE_DATA) are delivered on the calling thread after the queue.
+	//config == NULL - block when the queue is full
+	int32_t		(*start_async_notify)(Vec v, const obs_async_config_t* config);
+	int32_t		(*stop_async_notify)(Vec v);
+	int32_t		(*flush_notify)(Vec v);
+
+	//hash index over the key_size bytes at key_offset of every element, kept in sync through
+	//the observer (not together with async notify). find uses it for the Vec's own compare fn,
+	//which must give equal elements equal keys, other cmp scan. Elements changed in place
+	//need reindex. hash/eq NULL - bytewise
+	int32_t		(*attach_index)(Vec v, size_t key_offset, size_t key_size, hmap_hash_fn hash, hmap_eq_fn eq);
+	int32_t		(*detach_index)(Vec v);
+	int32_t		(*reindex)(Vec v);
+	//first element with key, NULL - not found
+	void*			(*find_by_key)(const Vec v, const void* key);
+
 } VectorInterface;
 
 extern VectorInterface iVec;
@@ -0,0 +1,286 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocator_i.h"
+#include "arena_allocator_i.h"
+
+#define ARENA_ALIGN_UP(n)		(((n) + (ARENA_ALIGNMENT - 1)) & ~((size_t)ARENA_ALIGNMENT - 1))
+
+struct arena_chunk_t {
+  arena_chunk_t*  next;
+  size_t          capacity;
+  size_t          used;
+  char*           data;
+};
+
+struct Arena_t {
+  arena_chunk_t*            first;
+  arena_chunk_t*            current;
+  size_t                    chunk_size;
+  const AllocatorInterface* backing;
+};
+
+//every block is prefixed with its owner, so realloc works no matter which arena is bound
+typedef struct {
+  Arena   arena;
+  size_t  size;
+} arena_block_t;
+
+#define ARENA_HEADER_SIZE		ARENA_ALIGN_UP(sizeof(arena_block_t))
+
+static ALLOCATOR_THREAD_LOCAL Arena bound_arena = NULL;
+
+static arena_chunk_t* _arena_new_chunk(Arena arena, size_t min_size) {
+  size_t capacity = min_size > arena->chunk_size ? min_size : arena->chunk_size;
+
+  arena_chunk_t* chunk = arena->backing->malloc(ARENA_ALIGN_UP(sizeof(arena_chunk_t)) + capacity);
+  if (chunk == NULL) {
+    return NULL;
+  }
+
+  chunk->next = NULL;
+  chunk->capacity = capacity;
+  chunk->used = 0;
+  chunk->data = (char*)chunk + ARENA_ALIGN_UP(sizeof(arena_chunk_t));
+
+  return chunk;
+}
+
+static void* _arena_alloc(Arena arena, size_t size) {
+  size_t needed = ARENA_HEADER_SIZE + ARENA_ALIGN_UP(size);
+  arena_chunk_t* chunk = arena->current;
+
+  //walk forward through chunks kept after reset/rewind before asking for a new one
+  while (chunk->capacity - chunk->used < needed) {
+    if (chunk->next == NULL) {
+      arena_chunk_t* new_chunk = _arena_new_chunk(arena, needed);
+      if (new_chunk == NULL) {
+        return NULL;
+      }
+      chunk->next = new_chunk;
+    }
+    else if (chunk->next->capacity < needed) {
+      //too small for this request -> put a dedicated chunk in front of it
+      arena_chunk_t* new_chunk = _arena_new_chunk(arena, needed);
+      if (new_chunk == NULL) {
+        return NULL;
+      }
+      new_chunk->next = chunk->next;
+      chunk->next = new_chunk;
+    }
+
+    chunk = chunk->next;
+    chunk->used = 0;
+  }
+
+  arena->current = chunk;
+
+  arena_block_t* block = (arena_block_t*)(chunk->data + chunk->used);
+  block->arena = arena;
+  block->size = size;
+  chunk->used += needed;
+
+  return (char*)block + ARENA_HEADER_SIZE;
+}
+
+//live cycle
+static Arena construct(size_t chunk_size) {
+  const AllocatorInterface* backing = CurrentAllocator;
+
+  //chunks can't come from an arena themselves
+  if (backing == &ArenaAllocator) {
+    backing = &DefaultAllocator;
+  }
+
+  Arena arena = backing->malloc(sizeof(struct Arena_t));
+  if (arena == NULL) {
+    return NULL;
+  }
+
+  arena->chunk_size = chunk_size == 0 ? ARENA_DEFAULT_CHUNK_SIZE : ARENA_ALIGN_UP(chunk_size);
+  arena->backing = backing;
+  arena->first = _arena_new_chunk(arena, arena->chunk_size);
+
+  if (arena->first == NULL) {
+    backing->free(arena);
+    return NULL;
+  }
+
+  arena->current = arena->first;
+
+  return arena;
+}
+
+static void destruct(Arena arena) {
+  if (arena == NULL) {
+    return;
+  }
+
+  if (bound_arena == arena) {
+    bound_arena = NULL;
+  }
+
+  arena_chunk_t* chunk = arena->first;
+  while (chunk != NULL) {
+    arena_chunk_t* next = chunk->next;
+    arena->backing->free(chunk);
+    chunk = next;
+  }
+
+  arena->backing->free(arena);
+}
+
+//binding
+static AllocatorInterface* bind(Arena arena) {
+  bound_arena = arena;
+  return &ArenaAllocator;
+}
+
+static Arena current(void) {
+  return bound_arena;
+}
+
+//bulk release
+static void reset(Arena arena) {
+  if (arena == NULL) {
+    return;
+  }
+
+  //chunks are kept for reuse, only the bump pointers go back
+  for (arena_chunk_t* chunk = arena->first; chunk != NULL; chunk = chunk->next) {
+    chunk->used = 0;
+  }
+
+  arena->current = arena->first;
+}
+
+static arena_mark_t mark(const Arena arena) {
+  arena_mark_t m = { NULL, 0 };
+
+  if (arena == NULL) {
+    return m;
+  }
+
+  m.chunk = arena->current;
+  m.used = arena->current->used;
+  return m;
+}
+
+static void rewind(Arena arena, arena_mark_t m) {
+  if (arena == NULL || m.chunk == NULL) {
+    return;
+  }
+
+  m.chunk->used = m.used;
+  for (arena_chunk_t* chunk = m.chunk->next; chunk != NULL; chunk = chunk->next) {
+    chunk->used = 0;
+  }
+
+  arena->current = m.chunk;
+}
+
+//state
+static size_t used(const Arena arena) {
+  size_t total = 0;
+
+  if (arena == NULL) {
+    return 0;
+  }
+
+  for (arena_chunk_t* chunk = arena->first; chunk != NULL; chunk = chunk->next) {
+    total += chunk->used;
+  }
+
+  return total;
+}
+
+static size_t reserved(const Arena arena) {
+  size_t total = 0;
+
+  if (arena == NULL) {
+    return 0;
+  }
+
+  for (arena_chunk_t* chunk = arena->first; chunk != NULL; chunk = chunk->next) {
+    total += chunk->capacity;
+  }
+
+  return total;
+}
+
+//AllocatorInterface
+static void* arena_malloc(size_t size) {
+  if (bound_arena == NULL) {
+    return NULL;
+  }
+
+  return _arena_alloc(bound_arena, size);
+}
+
+static void arena_free(void* ptr) {
+  //memory goes back on reset/rewind
+  (void)ptr;
+}
+
+static void* arena_realloc(void* ptr, size_t size) {
+  if (ptr == NULL) {
+    return arena_malloc(size);
+  }
+
+  arena_block_t* block = (arena_block_t*)((char*)ptr - ARENA_HEADER_SIZE);
+  Arena arena = block->arena;
+  arena_chunk_t* chunk = arena->current;
+
+  //last block handed out -> move the bump pointer instead of copying
+  char* block_end = (char*)ptr + ARENA_ALIGN_UP(block->size);
+  if (block_end == chunk->data + chunk->used) {
+    size_t block_start = (char*)block - chunk->data;
+    size_t needed = ARENA_HEADER_SIZE + ARENA_ALIGN_UP(size);
+
+    if (chunk->capacity - block_start >= needed) {
+      chunk->used = block_start + needed;
+      block->size = size;
+      return ptr;
+    }
+  }
+
+  if (size <= block->size) {
+    block->size = size;
+    return ptr;
+  }
+
+  void* new_ptr = _arena_alloc(arena, size);
+  if (new_ptr == NULL) {
+    return NULL;
+  }
+
+  memcpy(new_ptr, ptr, block->size);
+  return new_ptr;
+}
+
+static void* arena_calloc(size_t count, size_t size) {
+  if (size != 0 && count > (size_t)-1 / size) {
+    return NULL;
+  }
+
+  void* ptr = arena_malloc(count * size);
+  if (ptr != NULL) {
+    memset(ptr, 0, count * size);
+  }
+
+  return ptr;
+}
+
+AllocatorInterface ArenaAllocator = { arena_malloc, arena_free, arena_realloc, arena_calloc };
+
+ArenaInterface_t iArena = {
+  .construct = construct,
+  .destruct = destruct,
+  .bind = bind,
+  .current = current,
+  .reset = reset,
+  .mark = mark,
+  .rewind = rewind,
+  .used = used,
+  .reserved = reserved
+};
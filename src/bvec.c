@@ -0,0 +1,717 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocator_i.h"
+#include "simd_scan_i.h"
+#include "bvec_i.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BVEC_X86
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SIMD_TARGET(isa)
+#else
+#define SIMD_TARGET(isa)		__attribute__((target(isa)))
+#endif
+
+#define BVEC_OP__AND			0
+#define BVEC_OP__OR				1
+#define BVEC_OP__XOR			2
+#define BVEC_OP__ANDNOT		3
+
+//samples[s] - set bits in the words before s * BVEC_RANK_SAMPLE_WORDS, valid until a change
+struct tagBitVector {
+  uint64_t*                 data;
+  size_t                    size;
+  size_t                    word_capacity;
+
+  size_t*                   samples;
+  size_t                    sample_capacity;
+  int                       samples_valid;
+
+  const AllocatorInterface* allocator;
+  uint32_t                  error;
+};
+
+static inline uint32_t _ctz64(uint64_t mask) {
+#if defined(_MSC_VER) && defined(_WIN64)
+  unsigned long index;
+  _BitScanForward64(&index, mask);
+  return (uint32_t)index;
+#elif defined(_MSC_VER)
+  //no 64 bit scans on 32 bit targets
+  unsigned long index;
+  if (_BitScanForward(&index, (unsigned long)mask)) {
+    return (uint32_t)index;
+  }
+  _BitScanForward(&index, (unsigned long)(mask >> 32));
+  return (uint32_t)index + 32;
+#else
+  return (uint32_t)__builtin_ctzll(mask);
+#endif
+}
+
+static inline uint32_t _popcount64(uint64_t word) {
+  word = word - ((word >> 1) & 0x5555555555555555ull);
+  word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+  return (uint32_t)((((word + (word >> 4)) & 0x0F0F0F0F0F0F0F0Full) * 0x0101010101010101ull) >> 56);
+}
+
+static inline size_t _word_count(size_t bits) {
+  return (bits + 63) >> 6;
+}
+
+//bits of the last word that are inside the vector
+static inline uint64_t _tail_mask(size_t bits) {
+  return (bits & 63) == 0 ? ~(uint64_t)0 : ((uint64_t)1 << (bits & 63)) - 1;
+}
+
+static inline void _clear_tail(BVec v) {
+  if (v->size > 0) {
+    v->data[_word_count(v->size) - 1] &= _tail_mask(v->size);
+  }
+}
+
+static int32_t _reserve_words(BVec v, size_t words) {
+  if (words <= v->word_capacity) {
+    return VEC_OK;
+  }
+
+  size_t capacity = v->word_capacity * VEC_REALLOC_SCALE_FACTOR;
+  if (capacity < words) {
+    capacity = words;
+  }
+
+  uint64_t* data = v->allocator->realloc(v->data, capacity * sizeof(uint64_t));
+  if (data == NULL) {
+    v->error = VEC_ERR__REALLOC;
+    return VEC_ERR__REALLOC;
+  }
+
+  v->data = data;
+  v->word_capacity = capacity;
+
+  return VEC_OK;
+}
+
+static int32_t _check_index(const BVec v, size_t index) {
+  if (index >= v->size) {
+    v->error = VEC_ERR__INVALID_INDEX;
+    return VEC_ERR__INVALID_INDEX;
+  }
+
+  return VEC_OK;
+}
+
+static int32_t _build_samples(const BVec v) {
+  if (v->samples_valid) {
+    return VEC_OK;
+  }
+
+  size_t words = _word_count(v->size);
+  size_t count = (words / BVEC_RANK_SAMPLE_WORDS) + 1;
+  if (count > v->sample_capacity) {
+    size_t* samples = v->allocator->realloc(v->samples, count * sizeof(size_t));
+    if (samples == NULL) {
+      v->error = VEC_ERR__MALLOC;
+      return VEC_ERR__MALLOC;
+    }
+
+    v->samples = samples;
+    v->sample_capacity = count;
+  }
+
+  size_t total = 0;
+  for (size_t s = 0; s < count; s++) {
+    v->samples[s] = total;
+
+    size_t last = (s + 1) * BVEC_RANK_SAMPLE_WORDS;
+    for (size_t w = s * BVEC_RANK_SAMPLE_WORDS; w < last && w < words; w++) {
+      total += _popcount64(v->data[w]);
+    }
+  }
+
+  v->samples_valid = 1;
+
+  return VEC_OK;
+}
+
+//bulk kernels
+static void _scalar_op(uint64_t* dst, const uint64_t* src, size_t words, int op) {
+  switch (op) {
+    case BVEC_OP__AND:
+      for (size_t i = 0; i < words; i++) {
+        dst[i] &= src[i];
+      }
+      break;
+    case BVEC_OP__OR:
+      for (size_t i = 0; i < words; i++) {
+        dst[i] |= src[i];
+      }
+      break;
+    case BVEC_OP__XOR:
+      for (size_t i = 0; i < words; i++) {
+        dst[i] ^= src[i];
+      }
+      break;
+    default:
+      for (size_t i = 0; i < words; i++) {
+        dst[i] &= ~src[i];
+      }
+      break;
+  }
+}
+
+#ifdef BVEC_X86
+SIMD_TARGET("avx2")
+static void _avx2_op(uint64_t* dst, const uint64_t* src, size_t words, int op) {
+  size_t i = 0;
+  for (; i + 4 <= words; i += 4) {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(dst + i));
+    __m256i b = _mm256_loadu_si256((const __m256i*)(src + i));
+
+    switch (op) {
+      case BVEC_OP__AND:
+        a = _mm256_and_si256(a, b);
+        break;
+      case BVEC_OP__OR:
+        a = _mm256_or_si256(a, b);
+        break;
+      case BVEC_OP__XOR:
+        a = _mm256_xor_si256(a, b);
+        break;
+      default:
+        a = _mm256_andnot_si256(b, a);
+        break;
+    }
+
+    _mm256_storeu_si256((__m256i*)(dst + i), a);
+  }
+
+  _scalar_op(dst + i, src + i, words - i, op);
+}
+#endif
+
+static int32_t _bulk(BVec dst, const BVec src, int op) {
+  if (dst == NULL || src == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (dst->size != src->size) {
+    dst->error = VEC_ERR__DIFFERENT_TYPES;
+    return VEC_ERR__DIFFERENT_TYPES;
+  }
+
+  size_t words = _word_count(dst->size);
+
+#ifdef BVEC_X86
+  if (iSimdScan.isa() >= SIMD_ISA__AVX2) {
+    _avx2_op(dst->data, src->data, words, op);
+    dst->samples_valid = 0;
+    return VEC_OK;
+  }
+#endif
+
+  _scalar_op(dst->data, src->data, words, op);
+  dst->samples_valid = 0;
+
+  return VEC_OK;
+}
+
+//live cycle
+static BVec construct_with_allocator(size_t size, const AllocatorInterface* allocator) {
+  if (allocator == NULL) {
+    allocator = CurrentAllocator;
+  }
+
+  BVec v = allocator->malloc(sizeof(struct tagBitVector));
+  if (v == NULL) {
+    return NULL;
+  }
+
+  v->data = NULL;
+  v->size = 0;
+  v->word_capacity = 0;
+  v->samples = NULL;
+  v->sample_capacity = 0;
+  v->samples_valid = 0;
+  v->allocator = allocator;
+  v->error = VEC_OK;
+
+  size_t words = _word_count(size);
+  if (words > 0) {
+    v->data = allocator->calloc(words, sizeof(uint64_t));
+    if (v->data == NULL) {
+      allocator->free(v);
+      return NULL;
+    }
+
+    v->word_capacity = words;
+    v->size = size;
+  }
+
+  return v;
+}
+
+static BVec construct(size_t size) {
+  return construct_with_allocator(size, NULL);
+}
+
+static BVec copy(const BVec v) {
+  if (v == NULL) {
+    return NULL;
+  }
+
+  BVec res = construct_with_allocator(0, v->allocator);
+  if (res == NULL) {
+    return NULL;
+  }
+
+  size_t words = _word_count(v->size);
+  if (_reserve_words(res, words) < 0) {
+    res->allocator->free(res);
+    return NULL;
+  }
+
+  if (words > 0) {
+    memcpy(res->data, v->data, words * sizeof(uint64_t));
+  }
+  res->size = v->size;
+
+  return res;
+}
+
+static int32_t destruct(BVec v) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  v->allocator->free(v->samples);
+  v->allocator->free(v->data);
+  v->allocator->free(v);
+
+  return VEC_OK;
+}
+
+//info
+static size_t size(const BVec v) {
+  return v != NULL ? v->size : 0;
+}
+
+static size_t capacity(const BVec v) {
+  return v != NULL ? v->word_capacity * 64 : 0;
+}
+
+static uint32_t error(const BVec v) {
+  return v != NULL ? v->error : (uint32_t)VEC_ERR__NULL_VEC;
+}
+
+//memory
+static int32_t reserve(BVec v, size_t capacity) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  return _reserve_words(v, _word_count(capacity));
+}
+
+static int32_t resize(BVec v, size_t size) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  size_t old_words = _word_count(v->size);
+  size_t words = _word_count(size);
+
+  int32_t res = _reserve_words(v, words);
+  if (res < 0) {
+    return res;
+  }
+
+  //the old tail bits are already 0
+  if (words > old_words) {
+    memset(v->data + old_words, 0, (words - old_words) * sizeof(uint64_t));
+  }
+
+  v->size = size;
+  _clear_tail(v);
+  v->samples_valid = 0;
+
+  return VEC_OK;
+}
+
+static int32_t push_back(BVec v, int bit) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if ((v->size & 63) == 0) {
+    int32_t res = _reserve_words(v, _word_count(v->size) + 1);
+    if (res < 0) {
+      return res;
+    }
+    v->data[v->size >> 6] = 0;
+  }
+
+  if (bit) {
+    v->data[v->size >> 6] |= (uint64_t)1 << (v->size & 63);
+  }
+  v->size++;
+  v->samples_valid = 0;
+
+  return VEC_OK;
+}
+
+//single bits
+static int32_t set(BVec v, size_t index) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  int32_t res = _check_index(v, index);
+  if (res < 0) {
+    return res;
+  }
+
+  v->data[index >> 6] |= (uint64_t)1 << (index & 63);
+  v->samples_valid = 0;
+
+  return VEC_OK;
+}
+
+static int32_t reset(BVec v, size_t index) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  int32_t res = _check_index(v, index);
+  if (res < 0) {
+    return res;
+  }
+
+  v->data[index >> 6] &= ~((uint64_t)1 << (index & 63));
+  v->samples_valid = 0;
+
+  return VEC_OK;
+}
+
+static int32_t flip(BVec v, size_t index) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  int32_t res = _check_index(v, index);
+  if (res < 0) {
+    return res;
+  }
+
+  v->data[index >> 6] ^= (uint64_t)1 << (index & 63);
+  v->samples_valid = 0;
+
+  return VEC_OK;
+}
+
+static int32_t assign(BVec v, size_t index, int bit) {
+  return bit ? set(v, index) : reset(v, index);
+}
+
+static int32_t test(const BVec v, size_t index) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  int32_t res = _check_index(v, index);
+  if (res < 0) {
+    return res;
+  }
+
+  return (int32_t)((v->data[index >> 6] >> (index & 63)) & 1);
+}
+
+//ranges
+static int32_t assign_range(BVec v, size_t begin_index, size_t end_index, int bit) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (begin_index > end_index || end_index > v->size) {
+    v->error = VEC_ERR__INVALID_INDEX;
+    return VEC_ERR__INVALID_INDEX;
+  }
+
+  if (begin_index == end_index) {
+    return VEC_OK;
+  }
+
+  size_t first = begin_index >> 6;
+  size_t last = (end_index - 1) >> 6;
+  uint64_t first_mask = ~(uint64_t)0 << (begin_index & 63);
+  uint64_t last_mask = _tail_mask(end_index);
+
+  if (first == last) {
+    first_mask &= last_mask;
+  }
+
+  if (bit) {
+    v->data[first] |= first_mask;
+  }
+  else {
+    v->data[first] &= ~first_mask;
+  }
+
+  if (last > first) {
+    if (last > first + 1) {
+      memset(v->data + first + 1, bit ? 0xFF : 0, (last - first - 1) * sizeof(uint64_t));
+    }
+
+    if (bit) {
+      v->data[last] |= last_mask;
+    }
+    else {
+      v->data[last] &= ~last_mask;
+    }
+  }
+
+  v->samples_valid = 0;
+
+  return VEC_OK;
+}
+
+static int32_t fill(BVec v, int bit) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  return assign_range(v, 0, v->size, bit);
+}
+
+static int32_t invert(BVec v) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  size_t words = _word_count(v->size);
+  for (size_t i = 0; i < words; i++) {
+    v->data[i] = ~v->data[i];
+  }
+
+  _clear_tail(v);
+  v->samples_valid = 0;
+
+  return VEC_OK;
+}
+
+//bulk
+static int32_t and_with(BVec dst, const BVec src) {
+  return _bulk(dst, src, BVEC_OP__AND);
+}
+
+static int32_t or_with(BVec dst, const BVec src) {
+  return _bulk(dst, src, BVEC_OP__OR);
+}
+
+static int32_t xor_with(BVec dst, const BVec src) {
+  return _bulk(dst, src, BVEC_OP__XOR);
+}
+
+static int32_t andnot_with(BVec dst, const BVec src) {
+  return _bulk(dst, src, BVEC_OP__ANDNOT);
+}
+
+//counting
+static size_t count(const BVec v) {
+  if (v == NULL) {
+    return 0;
+  }
+
+  size_t words = _word_count(v->size);
+  if (_build_samples(v) == VEC_OK) {
+    size_t s = words / BVEC_RANK_SAMPLE_WORDS;
+    size_t total = v->samples[s];
+    for (size_t w = s * BVEC_RANK_SAMPLE_WORDS; w < words; w++) {
+      total += _popcount64(v->data[w]);
+    }
+    return total;
+  }
+
+  size_t total = 0;
+  for (size_t w = 0; w < words; w++) {
+    total += _popcount64(v->data[w]);
+  }
+
+  return total;
+}
+
+static size_t rank(const BVec v, size_t index) {
+  if (v == NULL) {
+    return 0;
+  }
+
+  if (index > v->size) {
+    index = v->size;
+  }
+
+  size_t word = index >> 6;
+  size_t total = 0;
+  size_t w = 0;
+  if (_build_samples(v) == VEC_OK) {
+    w = (word / BVEC_RANK_SAMPLE_WORDS) * BVEC_RANK_SAMPLE_WORDS;
+    total = v->samples[word / BVEC_RANK_SAMPLE_WORDS];
+  }
+
+  for (; w < word; w++) {
+    total += _popcount64(v->data[w]);
+  }
+
+  if ((index & 63) != 0) {
+    total += _popcount64(v->data[word] & _tail_mask(index));
+  }
+
+  return total;
+}
+
+//not select: that name is taken by <sys/select.h>
+static size_t select_bit(const BVec v, size_t k) {
+  if (v == NULL) {
+    return 0;
+  }
+
+  if (_build_samples(v) < 0) {
+    return v->size;
+  }
+
+  //last sample with at most k bits before it
+  size_t words = _word_count(v->size);
+  size_t low = 0;
+  size_t high = words / BVEC_RANK_SAMPLE_WORDS;
+  while (low < high) {
+    size_t mid = (low + high + 1) / 2;
+    if (v->samples[mid] <= k) {
+      low = mid;
+    }
+    else {
+      high = mid - 1;
+    }
+  }
+
+  k -= v->samples[low];
+  for (size_t w = low * BVEC_RANK_SAMPLE_WORDS; w < words; w++) {
+    uint64_t word = v->data[w];
+    uint32_t bits = _popcount64(word);
+    if (k < bits) {
+      for (; k > 0; k--) {
+        word &= word - 1;
+      }
+      return (w << 6) + _ctz64(word);
+    }
+    k -= bits;
+  }
+
+  return v->size;
+}
+
+//scans
+static size_t _find(const BVec v, size_t from, uint64_t invert) {
+  if (from >= v->size) {
+    return v->size;
+  }
+
+  size_t words = _word_count(v->size);
+  size_t w = from >> 6;
+  uint64_t word = (v->data[w] ^ invert) & (~(uint64_t)0 << (from & 63));
+
+  for (;;) {
+    if (word != 0) {
+      size_t index = (w << 6) + _ctz64(word);
+      return index < v->size ? index : v->size;
+    }
+
+    if (++w == words) {
+      return v->size;
+    }
+    word = v->data[w] ^ invert;
+  }
+}
+
+static size_t find_next(const BVec v, size_t from) {
+  return v != NULL ? _find(v, from, 0) : 0;
+}
+
+static size_t find_next_zero(const BVec v, size_t from) {
+  return v != NULL ? _find(v, from, ~(uint64_t)0) : 0;
+}
+
+static int32_t for_each_set(const BVec v, void (*cb)(size_t index, void* extra), void* extra) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (cb == NULL) {
+    v->error = VEC_ERR__NULL_CALLBACK;
+    return VEC_ERR__NULL_CALLBACK;
+  }
+
+  size_t words = _word_count(v->size);
+  for (size_t w = 0; w < words; w++) {
+    uint64_t word = v->data[w];
+    while (word != 0) {
+      cb((w << 6) + _ctz64(word), extra);
+      word &= word - 1;
+    }
+  }
+
+  return VEC_OK;
+}
+
+static uint64_t* words(const BVec v, size_t* count) {
+  if (v == NULL) {
+    return NULL;
+  }
+
+  if (count != NULL) {
+    *count = _word_count(v->size);
+  }
+
+  //the caller may write through it
+  v->samples_valid = 0;
+
+  return v->data;
+}
+
+BitVectorInterface iBVec = {
+  .construct = construct,
+  .construct_with_allocator = construct_with_allocator,
+  .copy = copy,
+  .destruct = destruct,
+  .size = size,
+  .capacity = capacity,
+  .error = error,
+  .reserve = reserve,
+  .resize = resize,
+  .push_back = push_back,
+  .set = set,
+  .reset = reset,
+  .flip = flip,
+  .assign = assign,
+  .test = test,
+  .assign_range = assign_range,
+  .fill = fill,
+  .invert = invert,
+  .and_with = and_with,
+  .or_with = or_with,
+  .xor_with = xor_with,
+  .andnot_with = andnot_with,
+  .count = count,
+  .rank = rank,
+  .select = select_bit,
+  .find_next = find_next,
+  .find_next_zero = find_next_zero,
+  .for_each_set = for_each_set,
+  .words = words
+};
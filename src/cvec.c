@@ -0,0 +1,247 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include "allocator_i.h"
+#include "cvec_i.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#define CVEC_MAX_SEGMENTS		64
+
+//a segment is its elements followed by one ready flag per element
+struct tagConcurrentVector {
+  size_t                    elem_size;
+  const AllocatorInterface* allocator;
+  _Atomic(char*)            segments[CVEC_MAX_SEGMENTS];
+  atomic_int                failed;
+
+  //slots handed out / prefix of slots that are written
+  atomic_size_t             reserved;
+  atomic_size_t             published;
+};
+
+static inline uint32_t _msb(size_t value) {
+#if defined(_MSC_VER) && defined(_WIN64)
+  unsigned long index;
+  _BitScanReverse64(&index, (unsigned long long)value);
+  return (uint32_t)index;
+#elif defined(_MSC_VER)
+  //size_t is 32 bit here
+  unsigned long index;
+  _BitScanReverse(&index, (unsigned long)value);
+  return (uint32_t)index;
+#else
+  return 63 - (uint32_t)__builtin_clzll((unsigned long long)value);
+#endif
+}
+
+static inline size_t _segment_capacity(uint32_t segment) {
+  return (size_t)CVEC_FIRST_SEGMENT_SIZE << segment;
+}
+
+//index + first segment size has its highest bit at segment + log2(first segment size)
+static inline void _locate(size_t index, uint32_t* segment, size_t* offset) {
+  size_t shifted = index + CVEC_FIRST_SEGMENT_SIZE;
+  uint32_t msb = _msb(shifted);
+
+  *segment = msb - _msb(CVEC_FIRST_SEGMENT_SIZE);
+  *offset = shifted - ((size_t)1 << msb);
+}
+
+static inline atomic_uchar* _ready_flags(const CVec cv, char* segment_data, uint32_t segment) {
+  return (atomic_uchar*)(segment_data + (_segment_capacity(segment) * cv->elem_size));
+}
+
+//racing threads both allocate, the loser frees its copy
+static char* _segment(CVec cv, uint32_t segment) {
+  char* data = atomic_load_explicit(&cv->segments[segment], memory_order_acquire);
+  if (data != NULL) {
+    return data;
+  }
+
+  size_t capacity = _segment_capacity(segment);
+  char* fresh = cv->allocator->calloc(capacity, cv->elem_size + sizeof(atomic_uchar));
+  if (fresh == NULL) {
+    return NULL;
+  }
+
+  if (atomic_compare_exchange_strong(&cv->segments[segment], &data, fresh)) {
+    return fresh;
+  }
+
+  cv->allocator->free(fresh);
+  return data;
+}
+
+//moves published over every written slot, any producer may finish the work of a slower one
+static void _advance(CVec cv) {
+  size_t pos = atomic_load(&cv->published);
+
+  for (;;) {
+    uint32_t segment;
+    size_t offset;
+    _locate(pos, &segment, &offset);
+
+    char* data = atomic_load(&cv->segments[segment]);
+    if (data == NULL || !atomic_load(&_ready_flags(cv, data, segment)[offset])) {
+      return;
+    }
+
+    if (atomic_compare_exchange_weak(&cv->published, &pos, pos + 1)) {
+      pos++;
+    }
+  }
+}
+
+static CVec construct(size_t elem_size) {
+  if (elem_size == 0) {
+    return NULL;
+  }
+
+  CVec cv = CurrentAllocator->malloc(sizeof(struct tagConcurrentVector));
+  if (cv == NULL) {
+    return NULL;
+  }
+
+  cv->elem_size = elem_size;
+  cv->allocator = CurrentAllocator;
+  for (size_t i = 0; i < CVEC_MAX_SEGMENTS; i++) {
+    atomic_init(&cv->segments[i], NULL);
+  }
+  atomic_init(&cv->failed, 0);
+  atomic_init(&cv->reserved, 0);
+  atomic_init(&cv->published, 0);
+
+  return cv;
+}
+
+static void destruct(CVec cv) {
+  if (cv == NULL) {
+    return;
+  }
+
+  for (size_t i = 0; i < CVEC_MAX_SEGMENTS; i++) {
+    cv->allocator->free(atomic_load(&cv->segments[i]));
+  }
+
+  cv->allocator->free(cv);
+}
+
+static int32_t push(CVec cv, const void* elem, size_t* index) {
+  if (cv == NULL) {
+    return CVEC_ERR__NULL_VEC;
+  }
+
+  if (elem == NULL) {
+    return CVEC_ERR__NULL_ELEM;
+  }
+
+  if (atomic_load_explicit(&cv->failed, memory_order_relaxed)) {
+    return CVEC_ERR__MALLOC;
+  }
+
+  size_t pos = atomic_fetch_add_explicit(&cv->reserved, 1, memory_order_relaxed);
+  uint32_t segment;
+  size_t offset;
+  _locate(pos, &segment, &offset);
+
+  char* data = _segment(cv, segment);
+  if (data == NULL) {
+    atomic_store(&cv->failed, 1);
+    return CVEC_ERR__MALLOC;
+  }
+
+  memcpy(data + (offset * cv->elem_size), elem, cv->elem_size);
+  atomic_store(&_ready_flags(cv, data, segment)[offset], 1);
+  _advance(cv);
+
+  if (index != NULL) {
+    *index = pos;
+  }
+
+  return CVEC_OK;
+}
+
+static int32_t reserve(CVec cv, size_t capacity) {
+  if (cv == NULL) {
+    return CVEC_ERR__NULL_VEC;
+  }
+
+  if (capacity == 0) {
+    return CVEC_OK;
+  }
+
+  uint32_t last;
+  size_t offset;
+  _locate(capacity - 1, &last, &offset);
+
+  for (uint32_t segment = 0; segment <= last; segment++) {
+    if (_segment(cv, segment) == NULL) {
+      return CVEC_ERR__MALLOC;
+    }
+  }
+
+  return CVEC_OK;
+}
+
+static void* at(const CVec cv, size_t index) {
+  if (cv == NULL || index >= atomic_load_explicit(&cv->published, memory_order_acquire)) {
+    return NULL;
+  }
+
+  uint32_t segment;
+  size_t offset;
+  _locate(index, &segment, &offset);
+
+  return atomic_load_explicit(&cv->segments[segment], memory_order_relaxed) + (offset * cv->elem_size);
+}
+
+static size_t size(const CVec cv) {
+  return cv != NULL ? atomic_load_explicit(&cv->published, memory_order_acquire) : 0;
+}
+
+static size_t elem_size(const CVec cv) {
+  return cv != NULL ? cv->elem_size : 0;
+}
+
+static int32_t for_each(CVec cv, void (*cb)(void* elem, size_t index, void* extra), void* extra) {
+  if (cv == NULL) {
+    return CVEC_ERR__NULL_VEC;
+  }
+
+  if (cb == NULL) {
+    return CVEC_ERR__NULL_CALLBACK;
+  }
+
+  size_t count = size(cv);
+  size_t index = 0;
+
+  //whole segments at a time
+  for (uint32_t segment = 0; index < count; segment++) {
+    char* data = atomic_load_explicit(&cv->segments[segment], memory_order_relaxed);
+    size_t last = _segment_capacity(segment);
+    if (last > count - index) {
+      last = count - index;
+    }
+
+    for (size_t offset = 0; offset < last; offset++) {
+      cb(data + (offset * cv->elem_size), index++, extra);
+    }
+  }
+
+  return CVEC_OK;
+}
+
+ConcurrentVectorInterface iCVec = {
+  .construct = construct,
+  .destruct = destruct,
+  .push = push,
+  .reserve = reserve,
+  .at = at,
+  .size = size,
+  .elem_size = elem_size,
+  .for_each = for_each
+};
@@ -0,0 +1,455 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocator_i.h"
+#include "dvec_i.h"
+
+//element i lives at position head + i: block (head + i) >> block_shift of the directory,
+//counted from first. The directory is a ring of dir_capacity (power of two) block pointers.
+struct tagChunkedVector {
+  size_t                    elem_size;
+  size_t                    block_shift;
+  size_t                    size;
+  size_t                    head;
+
+  char**                    dir;
+  size_t                    dir_capacity;
+  size_t                    first;
+  size_t                    block_count;
+  //last released block, saves a free/malloc pair when pushes and pops alternate at a block edge
+  char*                     spare;
+
+  const AllocatorInterface* allocator;
+  void                      (*elem_destructor)(void* elem);
+  uint32_t                  error;
+};
+
+static inline size_t _block_elems(const DVec v) {
+  return (size_t)1 << v->block_shift;
+}
+
+static inline char** _dir_slot(const DVec v, size_t block) {
+  return &v->dir[(v->first + block) & (v->dir_capacity - 1)];
+}
+
+static inline char* _elem(const DVec v, size_t index) {
+  size_t pos = v->head + index;
+  return *_dir_slot(v, pos >> v->block_shift) + ((pos & (_block_elems(v) - 1)) * v->elem_size);
+}
+
+static char* _take_block(DVec v) {
+  if (v->spare != NULL) {
+    char* block = v->spare;
+    v->spare = NULL;
+    return block;
+  }
+
+  return v->allocator->malloc(_block_elems(v) * v->elem_size);
+}
+
+static void _release_block(DVec v, char* block) {
+  if (v->spare == NULL) {
+    v->spare = block;
+    return;
+  }
+
+  v->allocator->free(block);
+}
+
+//copies the block pointers into a bigger ring starting at 0
+static int32_t _grow_dir(DVec v, size_t blocks) {
+  if (blocks <= v->dir_capacity) {
+    return VEC_OK;
+  }
+
+  size_t capacity = v->dir_capacity == 0 ? DVEC_MIN_DIRECTORY : v->dir_capacity;
+  while (capacity < blocks) {
+    capacity *= 2;
+  }
+
+  char** dir = v->allocator->malloc(capacity * sizeof(char*));
+  if (dir == NULL) {
+    v->error = VEC_ERR__MALLOC;
+    return VEC_ERR__MALLOC;
+  }
+
+  for (size_t i = 0; i < v->block_count; i++) {
+    dir[i] = *_dir_slot(v, i);
+  }
+
+  v->allocator->free(v->dir);
+  v->dir = dir;
+  v->dir_capacity = capacity;
+  v->first = 0;
+
+  return VEC_OK;
+}
+
+static void _release_all(DVec v) {
+  for (size_t i = 0; i < v->block_count; i++) {
+    _release_block(v, *_dir_slot(v, i));
+  }
+
+  v->block_count = 0;
+  v->first = 0;
+  v->head = 0;
+  v->size = 0;
+}
+
+static void _destroy_elements(DVec v) {
+  if (v->elem_destructor == NULL) {
+    return;
+  }
+
+  for (size_t i = 0; i < v->size; i++) {
+    v->elem_destructor(_elem(v, i));
+  }
+}
+
+//live cycle
+static DVec _construct(size_t elem_size, size_t block_size, const AllocatorInterface* allocator) {
+  if (elem_size == 0) {
+    return NULL;
+  }
+
+  if (allocator == NULL) {
+    allocator = CurrentAllocator;
+  }
+
+  DVec v = allocator->malloc(sizeof(struct tagChunkedVector));
+  if (v == NULL) {
+    return NULL;
+  }
+
+  v->elem_size = elem_size;
+  v->block_shift = 0;
+  while (((size_t)1 << (v->block_shift + 1)) <= block_size) {
+    v->block_shift++;
+  }
+
+  v->size = 0;
+  v->head = 0;
+  v->dir = NULL;
+  v->dir_capacity = 0;
+  v->first = 0;
+  v->block_count = 0;
+  v->spare = NULL;
+  v->allocator = allocator;
+  v->elem_destructor = NULL;
+  v->error = VEC_OK;
+
+  return v;
+}
+
+static DVec construct_with_allocator(size_t elem_size, const AllocatorInterface* allocator) {
+  return _construct(elem_size, elem_size > 0 ? DVEC_BLOCK_BYTES / elem_size : 0, allocator);
+}
+
+static DVec construct(size_t elem_size) {
+  return construct_with_allocator(elem_size, NULL);
+}
+
+static DVec construct_with_block_size(size_t elem_size, size_t block_size) {
+  //round up: the constructor rounds down
+  size_t rounded = 1;
+  while (rounded < block_size) {
+    rounded *= 2;
+  }
+
+  return _construct(elem_size, rounded, NULL);
+}
+
+static int32_t destruct(DVec v) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  _destroy_elements(v);
+  _release_all(v);
+
+  v->allocator->free(v->spare);
+  v->allocator->free(v->dir);
+  v->allocator->free(v);
+
+  return VEC_OK;
+}
+
+//info
+static size_t size(const DVec v) {
+  return v != NULL ? v->size : 0;
+}
+
+static size_t capacity(const DVec v) {
+  return v != NULL ? v->block_count * _block_elems(v) : 0;
+}
+
+static size_t elem_size(const DVec v) {
+  return v != NULL ? v->elem_size : 0;
+}
+
+static size_t block_size(const DVec v) {
+  return v != NULL ? _block_elems(v) : 0;
+}
+
+static uint32_t error(const DVec v) {
+  return v != NULL ? v->error : (uint32_t)VEC_ERR__NULL_VEC;
+}
+
+static int32_t set_elem_destructor(DVec v, void (*cb)(void* elem)) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  v->elem_destructor = cb;
+  return VEC_OK;
+}
+
+//memory
+static int32_t reserve(DVec v, size_t capacity) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  //one extra block: head may sit anywhere inside the first one
+  return _grow_dir(v, (capacity >> v->block_shift) + 2);
+}
+
+static int32_t shrink_to_fit(DVec v) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  v->allocator->free(v->spare);
+  v->spare = NULL;
+
+  return VEC_OK;
+}
+
+//ends
+static int32_t add(DVec v, const void* elem) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (elem == NULL) {
+    v->error = VEC_ERR__NULL_ELEM;
+    return VEC_ERR__NULL_ELEM;
+  }
+
+  //tail block is full
+  if (((v->head + v->size) >> v->block_shift) == v->block_count) {
+    int32_t res = _grow_dir(v, v->block_count + 1);
+    if (res < 0) {
+      return res;
+    }
+
+    char* block = _take_block(v);
+    if (block == NULL) {
+      v->error = VEC_ERR__MALLOC;
+      return VEC_ERR__MALLOC;
+    }
+
+    *_dir_slot(v, v->block_count) = block;
+    v->block_count++;
+  }
+
+  memcpy(_elem(v, v->size), elem, v->elem_size);
+  v->size++;
+
+  return VEC_OK;
+}
+
+static int32_t push_front(DVec v, const void* elem) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (elem == NULL) {
+    v->error = VEC_ERR__NULL_ELEM;
+    return VEC_ERR__NULL_ELEM;
+  }
+
+  //head block is full
+  if (v->head == 0) {
+    int32_t res = _grow_dir(v, v->block_count + 1);
+    if (res < 0) {
+      return res;
+    }
+
+    char* block = _take_block(v);
+    if (block == NULL) {
+      v->error = VEC_ERR__MALLOC;
+      return VEC_ERR__MALLOC;
+    }
+
+    v->first = (v->first - 1) & (v->dir_capacity - 1);
+    *_dir_slot(v, 0) = block;
+    v->block_count++;
+    v->head = _block_elems(v);
+  }
+
+  v->head--;
+  v->size++;
+  memcpy(_elem(v, 0), elem, v->elem_size);
+
+  return VEC_OK;
+}
+
+static void _take_out(DVec v, char* ptr, void* out) {
+  if (out != NULL) {
+    memcpy(out, ptr, v->elem_size);
+  }
+  else if (v->elem_destructor != NULL) {
+    v->elem_destructor(ptr);
+  }
+}
+
+static int32_t pop_back(DVec v, void* out) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (v->size == 0) {
+    v->error = VEC_ERR__EMPTY_VEC;
+    return VEC_ERR__EMPTY_VEC;
+  }
+
+  _take_out(v, _elem(v, v->size - 1), out);
+  v->size--;
+
+  if (v->size == 0) {
+    _release_all(v);
+    return VEC_OK;
+  }
+
+  //tail block became empty
+  size_t used = ((v->head + v->size - 1) >> v->block_shift) + 1;
+  if (used < v->block_count) {
+    v->block_count--;
+    _release_block(v, *_dir_slot(v, v->block_count));
+  }
+
+  return VEC_OK;
+}
+
+static int32_t pop_front(DVec v, void* out) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (v->size == 0) {
+    v->error = VEC_ERR__EMPTY_VEC;
+    return VEC_ERR__EMPTY_VEC;
+  }
+
+  _take_out(v, _elem(v, 0), out);
+  v->head++;
+  v->size--;
+
+  if (v->size == 0) {
+    _release_all(v);
+    return VEC_OK;
+  }
+
+  //head block became empty
+  if (v->head == _block_elems(v)) {
+    _release_block(v, *_dir_slot(v, 0));
+    v->first = (v->first + 1) & (v->dir_capacity - 1);
+    v->block_count--;
+    v->head = 0;
+  }
+
+  return VEC_OK;
+}
+
+static int32_t clear(DVec v) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  _destroy_elements(v);
+  _release_all(v);
+
+  return VEC_OK;
+}
+
+//access
+static void* at(const DVec v, size_t index) {
+  if (v == NULL) {
+    return NULL;
+  }
+
+  if (index >= v->size) {
+    v->error = VEC_ERR__INVALID_INDEX;
+    return NULL;
+  }
+
+  return _elem(v, index);
+}
+
+static void* front(const DVec v) {
+  return v != NULL && v->size > 0 ? _elem(v, 0) : NULL;
+}
+
+static void* back(const DVec v) {
+  return v != NULL && v->size > 0 ? _elem(v, v->size - 1) : NULL;
+}
+
+static int32_t for_each(DVec v, void (*cb)(void* elem, size_t index, void* extra), void* extra) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (cb == NULL) {
+    v->error = VEC_ERR__NULL_CALLBACK;
+    return VEC_ERR__NULL_CALLBACK;
+  }
+
+  if (v->size == 0) {
+    v->error = VEC_ERR__EMPTY_VEC;
+    return VEC_ERR__EMPTY_VEC;
+  }
+
+  //a block at a time
+  size_t index = 0;
+  size_t offset = v->head;
+  for (size_t block = 0; index < v->size; block++) {
+    char* ptr = *_dir_slot(v, block) + (offset * v->elem_size);
+    size_t last = _block_elems(v) - offset;
+    if (last > v->size - index) {
+      last = v->size - index;
+    }
+
+    for (size_t i = 0; i < last; i++) {
+      cb(ptr, index++, extra);
+      ptr += v->elem_size;
+    }
+    offset = 0;
+  }
+
+  return VEC_OK;
+}
+
+ChunkedVectorInterface iDVec = {
+  .construct = construct,
+  .construct_with_allocator = construct_with_allocator,
+  .construct_with_block_size = construct_with_block_size,
+  .destruct = destruct,
+  .size = size,
+  .capacity = capacity,
+  .elem_size = elem_size,
+  .block_size = block_size,
+  .error = error,
+  .set_elem_destructor = set_elem_destructor,
+  .reserve = reserve,
+  .shrink_to_fit = shrink_to_fit,
+  .add = add,
+  .push_front = push_front,
+  .pop_back = pop_back,
+  .pop_front = pop_front,
+  .clear = clear,
+  .at = at,
+  .front = front,
+  .back = back,
+  .for_each = for_each
+};
@@ -0,0 +1,355 @@
+//mremap is a linux extension
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include <stdlib.h>
+
+#include "allocator_i.h"
+#include "file_map_i.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+struct FileMap_t {
+#if defined(_WIN32)
+  HANDLE    file;
+  HANDLE    mapping;
+#else
+  int       fd;
+#endif
+  void*     base;
+  size_t    length;
+  uint32_t  flags;
+};
+
+#if defined(_WIN32)
+
+static void _unmap(FileMap map) {
+  if (map->base != NULL) {
+    UnmapViewOfFile(map->base);
+    map->base = NULL;
+  }
+
+  if (map->mapping != NULL) {
+    CloseHandle(map->mapping);
+    map->mapping = NULL;
+  }
+}
+
+//mapping an empty file is an error on windows, so length 0 maps nothing
+static int32_t _map(FileMap map) {
+  if (map->length == 0) {
+    return FILE_MAP_OK;
+  }
+
+  int write = (map->flags & FILE_MAP__WRITE) != 0;
+  uint64_t length = map->length;
+
+  map->mapping = CreateFileMappingA(map->file, NULL, write ? PAGE_READWRITE : PAGE_READONLY,
+    (DWORD)(length >> 32), (DWORD)(length & 0xFFFFFFFFu), NULL);
+  if (map->mapping == NULL) {
+    return FILE_MAP_ERR__MAP;
+  }
+
+  map->base = MapViewOfFile(map->mapping, write ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, map->length);
+  if (map->base == NULL) {
+    _unmap(map);
+    return FILE_MAP_ERR__MAP;
+  }
+
+  return FILE_MAP_OK;
+}
+
+static int32_t _set_file_length(FileMap map, size_t length) {
+  LARGE_INTEGER pos;
+  pos.QuadPart = (LONGLONG)length;
+
+  if (!SetFilePointerEx(map->file, pos, NULL, FILE_BEGIN) || !SetEndOfFile(map->file)) {
+    return FILE_MAP_ERR__RESIZE;
+  }
+
+  return FILE_MAP_OK;
+}
+
+static FileMap open_map(const char* path, uint32_t flags, size_t length) {
+  if (path == NULL) {
+    return NULL;
+  }
+
+  if (flags & FILE_MAP__CREATE) {
+    flags |= FILE_MAP__WRITE;
+  }
+
+  FileMap map = CurrentAllocator->calloc(1, sizeof(struct FileMap_t));
+  if (map == NULL) {
+    return NULL;
+  }
+
+  map->flags = flags;
+  map->file = CreateFileA(path, GENERIC_READ | ((flags & FILE_MAP__WRITE) ? GENERIC_WRITE : 0), FILE_SHARE_READ, NULL,
+    (flags & FILE_MAP__CREATE) ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (map->file == INVALID_HANDLE_VALUE) {
+    CurrentAllocator->free(map);
+    return NULL;
+  }
+
+  if (flags & FILE_MAP__CREATE) {
+    if (_set_file_length(map, length) < 0) {
+      goto error;
+    }
+    map->length = length;
+  }
+  else {
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(map->file, &size)) {
+      goto error;
+    }
+    map->length = (size_t)size.QuadPart;
+  }
+
+  if (_map(map) < 0) {
+    goto error;
+  }
+
+  return map;
+
+error:
+  CloseHandle(map->file);
+  CurrentAllocator->free(map);
+  return NULL;
+}
+
+static int32_t close_map(FileMap map) {
+  if (map == NULL) {
+    return FILE_MAP_ERR__NULL_MAP;
+  }
+
+  _unmap(map);
+  CloseHandle(map->file);
+  CurrentAllocator->free(map);
+
+  return FILE_MAP_OK;
+}
+
+static int32_t resize(FileMap map, size_t length) {
+  if (map == NULL) {
+    return FILE_MAP_ERR__NULL_MAP;
+  }
+
+  if ((map->flags & FILE_MAP__WRITE) == 0) {
+    return FILE_MAP_ERR__READ_ONLY;
+  }
+
+  //a file can't change size while a view of it is open
+  _unmap(map);
+
+  int32_t res = _set_file_length(map, length);
+  if (res == FILE_MAP_OK) {
+    map->length = length;
+  }
+
+  if (_map(map) < 0) {
+    return FILE_MAP_ERR__MAP;
+  }
+
+  return res;
+}
+
+static int32_t flush(FileMap map) {
+  if (map == NULL) {
+    return FILE_MAP_ERR__NULL_MAP;
+  }
+
+  if (map->base != NULL && !FlushViewOfFile(map->base, 0)) {
+    return FILE_MAP_ERR__FLUSH;
+  }
+
+  if ((map->flags & FILE_MAP__WRITE) && !FlushFileBuffers(map->file)) {
+    return FILE_MAP_ERR__FLUSH;
+  }
+
+  return FILE_MAP_OK;
+}
+
+#else
+
+static int32_t _map(FileMap map) {
+  if (map->length == 0) {
+    map->base = NULL;
+    return FILE_MAP_OK;
+  }
+
+  int prot = PROT_READ | ((map->flags & FILE_MAP__WRITE) ? PROT_WRITE : 0);
+  void* base = mmap(NULL, map->length, prot, MAP_SHARED, map->fd, 0);
+  if (base == MAP_FAILED) {
+    map->base = NULL;
+    return FILE_MAP_ERR__MAP;
+  }
+
+  map->base = base;
+  return FILE_MAP_OK;
+}
+
+static FileMap open_map(const char* path, uint32_t flags, size_t length) {
+  if (path == NULL) {
+    return NULL;
+  }
+
+  if (flags & FILE_MAP__CREATE) {
+    flags |= FILE_MAP__WRITE;
+  }
+
+  FileMap map = CurrentAllocator->calloc(1, sizeof(struct FileMap_t));
+  if (map == NULL) {
+    return NULL;
+  }
+
+  int oflags = (flags & FILE_MAP__WRITE) ? O_RDWR : O_RDONLY;
+  if (flags & FILE_MAP__CREATE) {
+    oflags |= O_CREAT | O_TRUNC;
+  }
+
+  map->flags = flags;
+  map->fd = open(path, oflags, 0644);
+  if (map->fd < 0) {
+    CurrentAllocator->free(map);
+    return NULL;
+  }
+
+  if (flags & FILE_MAP__CREATE) {
+    if (ftruncate(map->fd, (off_t)length) != 0) {
+      goto error;
+    }
+    map->length = length;
+  }
+  else {
+    struct stat st;
+    if (fstat(map->fd, &st) != 0) {
+      goto error;
+    }
+    map->length = (size_t)st.st_size;
+  }
+
+  if (_map(map) < 0) {
+    goto error;
+  }
+
+  return map;
+
+error:
+  close(map->fd);
+  CurrentAllocator->free(map);
+  return NULL;
+}
+
+static int32_t close_map(FileMap map) {
+  if (map == NULL) {
+    return FILE_MAP_ERR__NULL_MAP;
+  }
+
+  if (map->base != NULL) {
+    munmap(map->base, map->length);
+  }
+
+  close(map->fd);
+  CurrentAllocator->free(map);
+
+  return FILE_MAP_OK;
+}
+
+static int32_t _remap(FileMap map, size_t length) {
+  if (map->base == NULL || length == 0) {
+    if (map->base != NULL) {
+      munmap(map->base, map->length);
+    }
+    map->length = length;
+    return _map(map);
+  }
+
+#if defined(__linux__)
+  void* base = mremap(map->base, map->length, length, MREMAP_MAYMOVE);
+  if (base == MAP_FAILED) {
+    return FILE_MAP_ERR__MAP;
+  }
+
+  map->base = base;
+  map->length = length;
+  return FILE_MAP_OK;
+#else
+  munmap(map->base, map->length);
+  map->length = length;
+  return _map(map);
+#endif
+}
+
+static int32_t resize(FileMap map, size_t length) {
+  if (map == NULL) {
+    return FILE_MAP_ERR__NULL_MAP;
+  }
+
+  if ((map->flags & FILE_MAP__WRITE) == 0) {
+    return FILE_MAP_ERR__READ_ONLY;
+  }
+
+  //pages past the end of the file must never be mapped:
+  //grow the file before the mapping, shrink it after
+  if (length > map->length && ftruncate(map->fd, (off_t)length) != 0) {
+    return FILE_MAP_ERR__RESIZE;
+  }
+
+  size_t old_length = map->length;
+  int32_t res = _remap(map, length);
+  if (res < 0) {
+    return res;
+  }
+
+  if (length < old_length && ftruncate(map->fd, (off_t)length) != 0) {
+    return FILE_MAP_ERR__RESIZE;
+  }
+
+  return FILE_MAP_OK;
+}
+
+static int32_t flush(FileMap map) {
+  if (map == NULL) {
+    return FILE_MAP_ERR__NULL_MAP;
+  }
+
+  if (map->base != NULL && msync(map->base, map->length, MS_SYNC) != 0) {
+    return FILE_MAP_ERR__FLUSH;
+  }
+
+  return FILE_MAP_OK;
+}
+
+#endif
+
+static void* data(const FileMap map) {
+  return map != NULL ? map->base : NULL;
+}
+
+static size_t length(const FileMap map) {
+  return map != NULL ? map->length : 0;
+}
+
+static int32_t writable(const FileMap map) {
+  return map != NULL && (map->flags & FILE_MAP__WRITE) != 0;
+}
+
+FileMapInterface_t iFileMap = {
+  .open = open_map,
+  .close = close_map,
+  .data = data,
+  .length = length,
+  .writable = writable,
+  .resize = resize,
+  .flush = flush
+};
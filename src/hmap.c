@@ -0,0 +1,538 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocator_i.h"
+#include "hmap_i.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//control bytes: full slots hold the low 7 hash bits, the high bit marks empty/deleted
+#define HMAP_CTRL_EMPTY				((uint8_t)0x80)
+#define HMAP_CTRL_DELETED			((uint8_t)0xFE)
+
+//slots probed per step, the first HMAP_GROUP_WIDTH control bytes are mirrored past the end
+//so a group can be loaded at any position
+#define HMAP_GROUP_WIDTH			8
+
+#define HMAP_LSBS							0x0101010101010101ull
+#define HMAP_MSBS							0x8080808080808080ull
+
+//one block: capacity slots (key, padding, value, padding) followed by the control bytes
+struct tagHashMap {
+  size_t                    key_size;
+  size_t                    value_size;
+  size_t                    value_offset;
+  size_t                    slot_size;
+  hmap_hash_fn              hash;
+  hmap_eq_fn                eq;
+  const AllocatorInterface* allocator;
+
+  char*                     slots;
+  uint8_t*                  ctrl;
+  size_t                    capacity;
+  size_t                    size;
+  //inserts into empty slots left before the load factor (7/8) forces a rehash
+  size_t                    growth_left;
+  uint32_t                  error;
+};
+
+static inline uint32_t _ctz64(uint64_t mask) {
+#if defined(_MSC_VER) && defined(_WIN64)
+  unsigned long index;
+  _BitScanForward64(&index, mask);
+  return (uint32_t)index;
+#elif defined(_MSC_VER)
+  //no 64 bit scans on 32 bit targets
+  unsigned long index;
+  if (_BitScanForward(&index, (unsigned long)mask)) {
+    return (uint32_t)index;
+  }
+  _BitScanForward(&index, (unsigned long)(mask >> 32));
+  return (uint32_t)index + 32;
+#else
+  return (uint32_t)__builtin_ctzll(mask);
+#endif
+}
+
+static inline uint32_t _clz64(uint64_t mask) {
+#if defined(_MSC_VER) && defined(_WIN64)
+  unsigned long index;
+  _BitScanReverse64(&index, mask);
+  return 63 - (uint32_t)index;
+#elif defined(_MSC_VER)
+  unsigned long index;
+  if (_BitScanReverse(&index, (unsigned long)(mask >> 32))) {
+    return 31 - (uint32_t)index;
+  }
+  _BitScanReverse(&index, (unsigned long)mask);
+  return 63 - (uint32_t)index;
+#else
+  return (uint32_t)__builtin_clzll(mask);
+#endif
+}
+
+static inline uint64_t _load_group(const uint8_t* ctrl) {
+  uint64_t group;
+  memcpy(&group, ctrl, sizeof(group));
+  return group;
+}
+
+//high bit of every byte equal to h2, may report a false positive next to a real match
+static inline uint64_t _match(uint64_t group, uint8_t h2) {
+  uint64_t x = group ^ (HMAP_LSBS * h2);
+  return (x - HMAP_LSBS) & ~x & HMAP_MSBS;
+}
+
+//empty is the only control byte with bit 7 set and bit 1 clear
+static inline uint64_t _match_empty(uint64_t group) {
+  return group & ~(group << 6) & HMAP_MSBS;
+}
+
+static inline uint64_t _match_free(uint64_t group) {
+  return group & HMAP_MSBS;
+}
+
+static inline size_t _max_load(size_t capacity) {
+  return capacity - capacity / 8;
+}
+
+static inline size_t _alignment(size_t size) {
+  size_t align = size & (~size + 1);
+  return align == 0 || align > 16 ? 16 : align;
+}
+
+static inline char* _slot(const HMap m, size_t index) {
+  return m->slots + (index * m->slot_size);
+}
+
+static inline void _set_ctrl(HMap m, size_t index, uint8_t ctrl) {
+  m->ctrl[index] = ctrl;
+  if (index < HMAP_GROUP_WIDTH) {
+    m->ctrl[m->capacity + index] = ctrl;
+  }
+}
+
+static int _eq_bytes(const void* first, const void* second, size_t key_size) {
+  return memcmp(first, second, key_size) == 0;
+}
+
+static inline uint64_t _mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+static uint64_t hash_bytes(const void* key, size_t key_size) {
+  const uint8_t* bytes = key;
+
+  if (key_size == 8) {
+    uint64_t word;
+    memcpy(&word, bytes, 8);
+    return _mix(word);
+  }
+
+  if (key_size == 4) {
+    uint32_t word;
+    memcpy(&word, bytes, 4);
+    return _mix(word);
+  }
+
+  //FNV-1a
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < key_size; i++) {
+    h ^= bytes[i];
+    h *= 0x100000001b3ull;
+  }
+  return _mix(h);
+}
+
+//slot index of key or SIZE_MAX
+static size_t _find(const HMap m, const void* key, uint64_t hash) {
+  uint8_t h2 = (uint8_t)(hash & 0x7F);
+  size_t pos = (size_t)(hash >> 7) & (m->capacity - 1);
+
+  //triangular steps over groups reach every group of a power of two table
+  for (size_t step = HMAP_GROUP_WIDTH;; step += HMAP_GROUP_WIDTH) {
+    uint64_t group = _load_group(m->ctrl + pos);
+
+    for (uint64_t match = _match(group, h2); match != 0; match &= match - 1) {
+      size_t index = (pos + (_ctz64(match) >> 3)) & (m->capacity - 1);
+      if (m->eq(_slot(m, index), key, m->key_size)) {
+        return index;
+      }
+    }
+
+    if (_match_empty(group) != 0) {
+      return SIZE_MAX;
+    }
+
+    pos = (pos + step) & (m->capacity - 1);
+  }
+}
+
+//first empty or deleted slot on the probe sequence, the table always has an empty one
+static size_t _find_free(const HMap m, uint64_t hash) {
+  size_t pos = (size_t)(hash >> 7) & (m->capacity - 1);
+
+  for (size_t step = HMAP_GROUP_WIDTH;; step += HMAP_GROUP_WIDTH) {
+    uint64_t free_slots = _match_free(_load_group(m->ctrl + pos));
+    if (free_slots != 0) {
+      return (pos + (_ctz64(free_slots) >> 3)) & (m->capacity - 1);
+    }
+
+    pos = (pos + step) & (m->capacity - 1);
+  }
+}
+
+static int32_t _alloc_table(HMap m, size_t capacity, char** slots, uint8_t** ctrl) {
+  size_t slots_bytes = ((capacity * m->slot_size) + 15) & ~(size_t)15;
+  char* block = m->allocator->malloc(slots_bytes + capacity + HMAP_GROUP_WIDTH);
+  if (block == NULL) {
+    m->error = HMAP_ERR__MALLOC;
+    return HMAP_ERR__MALLOC;
+  }
+
+  *slots = block;
+  *ctrl = (uint8_t*)(block + slots_bytes);
+  memset(*ctrl, HMAP_CTRL_EMPTY, capacity + HMAP_GROUP_WIDTH);
+
+  return HMAP_OK;
+}
+
+//moves every entry into a table of capacity slots, also drops tombstones
+static int32_t _rehash(HMap m, size_t capacity) {
+  char* slots;
+  uint8_t* ctrl;
+
+  int32_t res = _alloc_table(m, capacity, &slots, &ctrl);
+  if (res < 0) {
+    return res;
+  }
+
+  char* old_slots = m->slots;
+  uint8_t* old_ctrl = m->ctrl;
+  size_t old_capacity = m->capacity;
+
+  m->slots = slots;
+  m->ctrl = ctrl;
+  m->capacity = capacity;
+
+  for (size_t i = 0; i < old_capacity; i++) {
+    if (old_ctrl[i] & 0x80) {
+      continue;
+    }
+
+    char* old_slot = old_slots + (i * m->slot_size);
+    uint64_t hash = m->hash(old_slot, m->key_size);
+    size_t index = _find_free(m, hash);
+
+    _set_ctrl(m, index, (uint8_t)(hash & 0x7F));
+    memcpy(_slot(m, index), old_slot, m->slot_size);
+  }
+
+  m->growth_left = _max_load(capacity) - m->size;
+  m->allocator->free(old_slots);
+
+  return HMAP_OK;
+}
+
+//live cycle
+static HMap construct_with_allocator(size_t key_size, size_t value_size, hmap_hash_fn hash, hmap_eq_fn eq, const AllocatorInterface* allocator) {
+  if (key_size == 0) {
+    return NULL;
+  }
+
+  if (allocator == NULL) {
+    allocator = CurrentAllocator;
+  }
+
+  HMap m = allocator->malloc(sizeof(struct tagHashMap));
+  if (m == NULL) {
+    return NULL;
+  }
+
+  size_t key_align = _alignment(key_size);
+  size_t value_align = value_size > 0 ? _alignment(value_size) : 1;
+  size_t slot_align = key_align > value_align ? key_align : value_align;
+
+  m->key_size = key_size;
+  m->value_size = value_size;
+  m->value_offset = (key_size + value_align - 1) & ~(value_align - 1);
+  m->slot_size = (m->value_offset + value_size + slot_align - 1) & ~(slot_align - 1);
+  m->hash = hash != NULL ? hash : hash_bytes;
+  m->eq = eq != NULL ? eq : _eq_bytes;
+  m->allocator = allocator;
+  m->capacity = HMAP_MIN_CAPACITY;
+  m->size = 0;
+  m->growth_left = _max_load(HMAP_MIN_CAPACITY);
+  m->error = HMAP_OK;
+
+  if (_alloc_table(m, HMAP_MIN_CAPACITY, &m->slots, &m->ctrl) < 0) {
+    allocator->free(m);
+    return NULL;
+  }
+
+  return m;
+}
+
+static HMap construct(size_t key_size, size_t value_size, hmap_hash_fn hash, hmap_eq_fn eq) {
+  return construct_with_allocator(key_size, value_size, hash, eq, NULL);
+}
+
+static int32_t destruct(HMap m) {
+  if (m == NULL) {
+    return HMAP_ERR__NULL_MAP;
+  }
+
+  m->allocator->free(m->slots);
+  m->allocator->free(m);
+
+  return HMAP_OK;
+}
+
+//info
+static size_t size(const HMap m) {
+  return m != NULL ? m->size : 0;
+}
+
+static size_t capacity(const HMap m) {
+  return m != NULL ? _max_load(m->capacity) : 0;
+}
+
+static uint32_t error(const HMap m) {
+  return m != NULL ? m->error : (uint32_t)HMAP_ERR__NULL_MAP;
+}
+
+//memory
+static int32_t reserve(HMap m, size_t count) {
+  if (m == NULL) {
+    return HMAP_ERR__NULL_MAP;
+  }
+
+  size_t new_capacity = m->capacity;
+  while (_max_load(new_capacity) < count) {
+    new_capacity *= 2;
+  }
+
+  if (new_capacity == m->capacity) {
+    return HMAP_OK;
+  }
+
+  return _rehash(m, new_capacity);
+}
+
+static int32_t clear(HMap m) {
+  if (m == NULL) {
+    return HMAP_ERR__NULL_MAP;
+  }
+
+  memset(m->ctrl, HMAP_CTRL_EMPTY, m->capacity + HMAP_GROUP_WIDTH);
+  m->size = 0;
+  m->growth_left = _max_load(m->capacity);
+
+  return HMAP_OK;
+}
+
+//NULL - allocation failed
+static char* _insert_slot(HMap m, const void* key, int32_t* inserted) {
+  uint64_t hash = m->hash(key, m->key_size);
+
+  size_t index = _find(m, key, hash);
+  if (index != SIZE_MAX) {
+    *inserted = 0;
+    return _slot(m, index);
+  }
+
+  index = _find_free(m, hash);
+
+  //a deleted slot is reused for free, an empty one uses up growth
+  if (m->growth_left == 0 && m->ctrl[index] == HMAP_CTRL_EMPTY) {
+    //mostly tombstones -> clean up in place, else double
+    size_t new_capacity = m->size < _max_load(m->capacity) / 2 ? m->capacity : m->capacity * 2;
+    if (_rehash(m, new_capacity) < 0) {
+      return NULL;
+    }
+    index = _find_free(m, hash);
+  }
+
+  if (m->ctrl[index] == HMAP_CTRL_EMPTY) {
+    m->growth_left--;
+  }
+
+  _set_ctrl(m, index, (uint8_t)(hash & 0x7F));
+  m->size++;
+
+  char* slot = _slot(m, index);
+  memcpy(slot, key, m->key_size);
+  memset(slot + m->value_offset, 0, m->value_size);
+
+  *inserted = 1;
+  return slot;
+}
+
+static int32_t put(HMap m, const void* key, const void* value) {
+  if (m == NULL) {
+    return HMAP_ERR__NULL_MAP;
+  }
+
+  if (key == NULL) {
+    m->error = HMAP_ERR__NULL_KEY;
+    return HMAP_ERR__NULL_KEY;
+  }
+
+  int32_t inserted;
+  char* slot = _insert_slot(m, key, &inserted);
+  if (slot == NULL) {
+    return HMAP_ERR__MALLOC;
+  }
+
+  if (value != NULL) {
+    memcpy(slot + m->value_offset, value, m->value_size);
+  }
+  else if (!inserted) {
+    memset(slot + m->value_offset, 0, m->value_size);
+  }
+
+  return inserted;
+}
+
+static void* get_or_insert(HMap m, const void* key, int32_t* inserted) {
+  if (m == NULL) {
+    return NULL;
+  }
+
+  if (key == NULL) {
+    m->error = HMAP_ERR__NULL_KEY;
+    return NULL;
+  }
+
+  int32_t is_new;
+  char* slot = _insert_slot(m, key, &is_new);
+  if (slot == NULL) {
+    return NULL;
+  }
+
+  if (inserted != NULL) {
+    *inserted = is_new;
+  }
+
+  return slot + m->value_offset;
+}
+
+static void* get(const HMap m, const void* key) {
+  if (m == NULL || key == NULL) {
+    return NULL;
+  }
+
+  size_t index = _find(m, key, m->hash(key, m->key_size));
+  return index != SIZE_MAX ? _slot(m, index) + m->value_offset : NULL;
+}
+
+static int32_t contains(const HMap m, const void* key) {
+  if (m == NULL || key == NULL) {
+    return 0;
+  }
+
+  return _find(m, key, m->hash(key, m->key_size)) != SIZE_MAX;
+}
+
+static int32_t remove_key(HMap m, const void* key, void* out) {
+  if (m == NULL) {
+    return HMAP_ERR__NULL_MAP;
+  }
+
+  if (key == NULL) {
+    m->error = HMAP_ERR__NULL_KEY;
+    return HMAP_ERR__NULL_KEY;
+  }
+
+  size_t index = _find(m, key, m->hash(key, m->key_size));
+  if (index == SIZE_MAX) {
+    m->error = HMAP_ERR__KEY_NOT_FOUND;
+    return HMAP_ERR__KEY_NOT_FOUND;
+  }
+
+  if (out != NULL) {
+    memcpy(out, _slot(m, index) + m->value_offset, m->value_size);
+  }
+
+  //every group window around the slot still has an empty byte -> no probe ever went past it,
+  //the slot can become empty instead of a tombstone
+  size_t before = (index - HMAP_GROUP_WIDTH) & (m->capacity - 1);
+  uint64_t empty_before = _match_empty(_load_group(m->ctrl + before));
+  uint64_t empty_after = _match_empty(_load_group(m->ctrl + index));
+  if (empty_before != 0 && empty_after != 0 && (_ctz64(empty_after) >> 3) + (_clz64(empty_before) >> 3) < HMAP_GROUP_WIDTH) {
+    _set_ctrl(m, index, HMAP_CTRL_EMPTY);
+    m->growth_left++;
+    m->size--;
+    return HMAP_OK;
+  }
+
+  _set_ctrl(m, index, HMAP_CTRL_DELETED);
+  m->size--;
+
+  return HMAP_OK;
+}
+
+//iteration
+static int32_t next(const HMap m, hmap_iter_t* it) {
+  if (m == NULL || it == NULL) {
+    return 0;
+  }
+
+  for (; it->index < m->capacity; it->index++) {
+    if (!(m->ctrl[it->index] & 0x80)) {
+      char* slot = _slot(m, it->index++);
+      it->key = slot;
+      it->value = slot + m->value_offset;
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static int32_t for_each(HMap m, void (*cb)(const void* key, void* value, void* extra), void* extra) {
+  if (m == NULL) {
+    return HMAP_ERR__NULL_MAP;
+  }
+
+  if (cb == NULL) {
+    m->error = HMAP_ERR__NULL_CALLBACK;
+    return HMAP_ERR__NULL_CALLBACK;
+  }
+
+  //a group at a time
+  for (size_t pos = 0; pos < m->capacity; pos += HMAP_GROUP_WIDTH) {
+    for (uint64_t full = ~_load_group(m->ctrl + pos) & HMAP_MSBS; full != 0; full &= full - 1) {
+      char* slot = _slot(m, pos + (_ctz64(full) >> 3));
+      cb(slot, slot + m->value_offset, extra);
+    }
+  }
+
+  return HMAP_OK;
+}
+
+HashMapInterface iHMap = {
+  .construct = construct,
+  .construct_with_allocator = construct_with_allocator,
+  .destruct = destruct,
+  .size = size,
+  .capacity = capacity,
+  .error = error,
+  .reserve = reserve,
+  .clear = clear,
+  .put = put,
+  .get_or_insert = get_or_insert,
+  .get = get,
+  .contains = contains,
+  .remove = remove_key,
+  .next = next,
+  .for_each = for_each,
+  .hash_bytes = hash_bytes
+};
@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <string.h>
 
 #include "allocator_i.h"
 #include "lvec_i.h"
@@ -8,35 +9,74 @@ struct tagLightVector {
 	size_t 		elem_size;
 	size_t 		capacity;
 	char* 		data;
+	size_t		inline_capacity;
+	const AllocatorInterface*	allocator;
 };
 
-static LVec construct(size_t elem_size) {
+//inline elements start right after the header, in the same block
+#define LVEC_INLINE_OFFSET		(((sizeof(struct tagLightVector) + 15) / 16) * 16)
+
+static int _is_inline(const LVec lvec) {
+  return lvec->inline_capacity > 0 && lvec->data == (char*)lvec + LVEC_INLINE_OFFSET;
+}
+
+//the allocator is kept, growth and destruct go through it whatever CurrentAllocator is then
+static LVec _construct(size_t elem_size, size_t inline_capacity, const AllocatorInterface* allocator) {
   if (elem_size == 0) {
     return NULL;
   }
 
-  LVec lvec = CurrentAllocator->malloc(sizeof(struct tagLightVector));
+  if (allocator == NULL) {
+    allocator = CurrentAllocator;
+  }
+
+  size_t block_size = inline_capacity > 0 ? LVEC_INLINE_OFFSET + (inline_capacity * elem_size) : sizeof(struct tagLightVector);
+  LVec lvec = allocator->malloc(block_size);
 
   if (lvec == NULL) {
     return NULL;
   }
 
-  lvec->capacity = LVEC_START_CAPACITY;
+  lvec->allocator = allocator;
   lvec->size = 0;
   lvec->elem_size = elem_size;
+  lvec->inline_capacity = inline_capacity;
 
-  lvec->data = CurrentAllocator->malloc(elem_size * LVEC_START_CAPACITY);
+  if (inline_capacity > 0) {
+    lvec->capacity = inline_capacity;
+    lvec->data = (char*)lvec + LVEC_INLINE_OFFSET;
+    return lvec;
+  }
+
+  lvec->capacity = LVEC_START_CAPACITY;
+  lvec->data = allocator->malloc(elem_size * LVEC_START_CAPACITY);
   if (lvec->data == NULL) {
-    CurrentAllocator->free(lvec);
+    allocator->free(lvec);
     return NULL;
   }
 
   return lvec;
 }
 
+static LVec construct_with_inline_capacity(size_t elem_size, size_t inline_capacity) {
+  return _construct(elem_size, inline_capacity, CurrentAllocator);
+}
+
+static LVec construct_with_allocator(size_t elem_size, const AllocatorInterface* allocator) {
+  return _construct(elem_size, LVEC_INLINE_CAPACITY, allocator);
+}
+
+static LVec construct(size_t elem_size) {
+  return _construct(elem_size, LVEC_INLINE_CAPACITY, CurrentAllocator);
+}
+
 static void destruct(LVec lvec) {
-  free(lvec->data);
-  free(lvec);
+  const AllocatorInterface* allocator = lvec->allocator;
+
+  if (!_is_inline(lvec)) {
+    allocator->free(lvec->data);
+  }
+  allocator->free(lvec);
 }
 
 static size_t size(const LVec lvec) {
@@ -47,13 +87,29 @@ static size_t elem_size(const LVec lvec) {
   return lvec->elem_size;
 }
 
-static _lvec_resize(LVec lvec) {
+static int32_t _lvec_resize(LVec lvec) {
   if (lvec == NULL) {
     return -1;
   }
 
   size_t new_capacity = lvec->capacity * LVEC_REALLOC_SCALE_FACTOR;
-  void* tmp = realloc(lvec->data, (new_capacity * lvec->elem_size));
+  if (new_capacity < LVEC_START_CAPACITY) {
+    new_capacity = LVEC_START_CAPACITY;
+  }
+
+  void* tmp = NULL;
+
+  //first growth past the inline storage moves elements to the heap
+  if (_is_inline(lvec)) {
+    tmp = lvec->allocator->malloc(new_capacity * lvec->elem_size);
+    if (tmp != NULL) {
+      memcpy(tmp, lvec->data, lvec->size * lvec->elem_size);
+    }
+  }
+  else {
+    tmp = lvec->allocator->realloc(lvec->data, (new_capacity * lvec->elem_size));
+  }
+
   if (tmp == NULL) {
     return -1;
   }
@@ -91,11 +147,7 @@ static int32_t erase_at(LVec lvec, size_t index) {
   }
 
   char* ptr = lvec->data + (index * lvec->elem_size);
-  char* last_elem = lvec->data + ((lvec->size - 1) * lvec->elem_size);
-
-  for (; ptr < last_elem; ptr++) {
-    *ptr = ptr[lvec->elem_size];
-  }
+  memmove(ptr, ptr + lvec->elem_size, (lvec->size - index - 1) * lvec->elem_size);
 
   lvec->size--;
 
@@ -108,6 +160,8 @@ static void* data(const LVec lvec) {
 
 LightVectorInterface iLVec = {
   .construct = construct,
+  .construct_with_inline_capacity = construct_with_inline_capacity,
+  .construct_with_allocator = construct_with_allocator,
   .destruct = destruct,
   .size = size,
   .elem_size = elem_size,
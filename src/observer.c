@@ -1,7 +1,18 @@
+#include <string.h>
+#include <stdatomic.h>
+#include <threads.h>
+#include <time.h>
+
 #include "observer_i.h"
 #include "allocator_i.h"
 #include "lvec_i.h"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#define OBS_ACTION_BITS		64
+
 typedef struct {
 	uint64_t	action_mask;
 	int8_t		auto_free_extra;
@@ -9,35 +20,393 @@ typedef struct {
 	void*			cb_extra;
 } subscriber_data_t;
 
+typedef struct {
+	void			(*cb)(int action, const void* call_extra, void* cb_extra);
+	void*			cb_extra;
+} dispatch_entry_t;
+
+//immutable once published: subs is a copy of the live subscribers for multi-bit actions,
+//dispatch holds the subscribers of action bit b in [offsets[b], offsets[b + 1]),
+//both arrays share the snapshot's allocation
+typedef struct obs_snapshot_t {
+	uint64_t								observable_actions;
+	size_t									sub_count;
+	subscriber_data_t*			subs;
+	dispatch_entry_t*				dispatch;
+	uint32_t								offsets[OBS_ACTION_BITS + 1];
+
+	//retired list, writers only
+	uint64_t								retire_epoch;
+	struct obs_snapshot_t*	next_retired;
+} obs_snapshot_t;
+
+//epoch based reclamation shared by all observers: a reader announces the global epoch
+//in its thread record for the duration of notify, a snapshot retired at epoch e is freed
+//once no record holds an epoch <= e. Records are reused after their thread exits.
+typedef struct ebr_record_t {
+	atomic_uint_least64_t	epoch;			//0 - not reading
+	atomic_int						in_use;
+	struct ebr_record_t*	next;
+	char									pad[64 - sizeof(atomic_uint_least64_t) - sizeof(atomic_int) - sizeof(void*)];
+} ebr_record_t;
+
+//bounded MPSC ring (per slot sequence numbers): producers claim a position with CAS,
+//the slot's seq tells whether it is free (== pos), filled (== pos + 1) or still in use
+typedef struct {
+	atomic_size_t	seq;
+	int						action;
+	int						skip;				//delivered inline instead, the slot only keeps the order
+	void*					extra;
+	void*					heap;				//snapshot too big for the slot
+	union {
+		max_align_t	align;
+		char				bytes[OBS_ASYNC_EXTRA_MAX];
+	} snapshot;
+} async_slot_t;
+
+typedef struct {
+	async_slot_t*	slots;
+	size_t				mask;
+	const AllocatorInterface*	allocator;
+	uint32_t			policy;
+	size_t				(*snapshot)(int action, const void* extra, void* out, size_t out_size);
+
+	atomic_size_t	enqueue_pos;
+	atomic_size_t	dequeue_pos;			//advanced under deliver_lock
+	atomic_size_t	published;
+	atomic_size_t	delivered;
+	atomic_uint_least64_t	dropped;
+
+	thrd_t				thread;
+	mtx_t					wake_lock;
+	cnd_t					wake;
+	atomic_int		sleeping;
+	atomic_int		stop;
+} async_queue_t;
+
+//notify only reads snapshot, subs_data is the source of truth for writers and
+//lookup an open addressing table callback -> subs_data index + 1
 struct Observer_t {
-	uint64_t	observable_actions;
-	LVec			subs_data;
+	_Atomic(obs_snapshot_t*)	snapshot;
+
+	//writers only, serialized by write_lock
+	mtx_t							write_lock;
+	LVec							subs_data;
+	uint32_t*					lookup;
+	size_t						lookup_capacity;
+	obs_snapshot_t*		retired;
+
+	//async mode: callbacks are serialized by deliver_lock
+	async_queue_t*		async;
+	mtx_t							deliver_lock;
+
+	//CurrentAllocator at construct, everything the observer allocates goes through it
+	const AllocatorInterface*	allocator;
 };
 
+static _Atomic(ebr_record_t*) ebr_records = NULL;
+static atomic_uint_least64_t ebr_epoch = 1;
+static once_flag ebr_once = ONCE_FLAG_INIT;
+static tss_t ebr_key;
+static int ebr_key_ready = 0;
+static ALLOCATOR_THREAD_LOCAL ebr_record_t* ebr_own = NULL;
+static ALLOCATOR_THREAD_LOCAL uint32_t ebr_depth = 0;
+
+//deliver_lock holds of the current thread, innermost first: a thread that holds it must not
+//wait for the dispatcher (blocked on the same lock), it drains the queue itself
+typedef struct deliver_hold_t {
+	Observer								obs;
+	struct deliver_hold_t*	prev;
+} deliver_hold_t;
+
+static ALLOCATOR_THREAD_LOCAL deliver_hold_t* deliver_held = NULL;
+
+static int32_t stop_async(Observer obs);
+
+static inline uint32_t _lowest_bit(uint64_t mask) {
+#if defined(_MSC_VER) && defined(_WIN64)
+	unsigned long index;
+	_BitScanForward64(&index, mask);
+	return (uint32_t)index;
+#elif defined(_MSC_VER)
+	//no 64 bit scans on 32 bit targets
+	unsigned long index;
+	if (_BitScanForward(&index, (unsigned long)mask)) {
+		return (uint32_t)index;
+	}
+	_BitScanForward(&index, (unsigned long)(mask >> 32));
+	return (uint32_t)index + 32;
+#else
+	return (uint32_t)__builtin_ctzll(mask);
+#endif
+}
+
+static inline size_t _hash_cb(const void* cb, size_t capacity) {
+	uint64_t h = (uint64_t)(uintptr_t)cb;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	return (size_t)h & (capacity - 1);
+}
+
+//epochs
+static void _ebr_release(void* rec) {
+	atomic_store(&((ebr_record_t*)rec)->in_use, 0);
+}
+
+static void _ebr_init(void) {
+	ebr_key_ready = tss_create(&ebr_key, _ebr_release) == thrd_success;
+}
+
+//NULL - no record could be allocated
+static ebr_record_t* _ebr_register(void) {
+	call_once(&ebr_once, _ebr_init);
+
+	ebr_record_t* rec;
+	for (rec = atomic_load(&ebr_records); rec != NULL; rec = rec->next) {
+		int expected = 0;
+		if (atomic_compare_exchange_strong(&rec->in_use, &expected, 1)) {
+			break;
+		}
+	}
+
+	//records are never unlinked, so pushing has no ABA problem
+	if (rec == NULL) {
+		rec = DefaultAllocator.calloc(1, sizeof(ebr_record_t));
+		if (rec == NULL) {
+			return NULL;
+		}
+
+		atomic_init(&rec->epoch, 0);
+		atomic_init(&rec->in_use, 1);
+		rec->next = atomic_load(&ebr_records);
+		while (!atomic_compare_exchange_weak(&ebr_records, &rec->next, rec));
+	}
+
+	if (ebr_key_ready) {
+		tss_set(ebr_key, rec);
+	}
+	ebr_own = rec;
+
+	return rec;
+}
+
+//nested notify keeps the outer epoch
+static ebr_record_t* _ebr_enter(void) {
+	ebr_record_t* rec = ebr_own != NULL ? ebr_own : _ebr_register();
+
+	if (rec != NULL && ebr_depth++ == 0) {
+		atomic_store(&rec->epoch, atomic_load(&ebr_epoch));
+	}
+
+	return rec;
+}
+
+static void _ebr_exit(ebr_record_t* rec) {
+	if (--ebr_depth == 0) {
+		atomic_store_explicit(&rec->epoch, 0, memory_order_release);
+	}
+}
+
+//oldest epoch a reader is still in, UINT64_MAX - no readers
+static uint64_t _ebr_oldest(void) {
+	uint64_t oldest = UINT64_MAX;
+
+	for (ebr_record_t* rec = atomic_load(&ebr_records); rec != NULL; rec = rec->next) {
+		uint64_t epoch = atomic_load(&rec->epoch);
+		if (epoch != 0 && epoch < oldest) {
+			oldest = epoch;
+		}
+	}
+
+	return oldest;
+}
+
+//snapshots
+static void _reclaim(Observer obs) {
+	uint64_t oldest = _ebr_oldest();
+	obs_snapshot_t** link = &obs->retired;
+
+	while (*link != NULL) {
+		obs_snapshot_t* snap = *link;
+		if (snap->retire_epoch < oldest) {
+			*link = snap->next_retired;
+			obs->allocator->free(snap);
+		}
+		else {
+			link = &snap->next_retired;
+		}
+	}
+}
+
+//builds a snapshot of the subscribers with a non empty mask and swaps it in,
+//the old one is retired. On allocation failure the old snapshot stays published.
+static int32_t _publish(Observer obs) {
+	subscriber_data_t* sub = iLVec.data(obs->subs_data);
+	size_t count = iLVec.size(obs->subs_data);
+	uint32_t offsets[OBS_ACTION_BITS + 1] = { 0 };
+	uint64_t observable_actions = 0;
+	size_t live = 0;
+	size_t entries = 0;
+
+	//count subscribers per bit, then turn counts into offsets
+	for (size_t i = 0; i < count; i++) {
+		if (sub[i].action_mask == 0) {
+			continue;
+		}
+
+		live++;
+		observable_actions |= sub[i].action_mask;
+		for (uint64_t mask = sub[i].action_mask; mask != 0; mask &= mask - 1) {
+			offsets[_lowest_bit(mask) + 1]++;
+			entries++;
+		}
+	}
+
+	for (size_t b = 0; b < OBS_ACTION_BITS; b++) {
+		offsets[b + 1] += offsets[b];
+	}
+
+	obs_snapshot_t* snap = obs->allocator->malloc(sizeof(obs_snapshot_t) + live * sizeof(subscriber_data_t) + entries * sizeof(dispatch_entry_t));
+	if (snap == NULL) {
+		return OBS_ERR__MALLOC;
+	}
+
+	snap->observable_actions = observable_actions;
+	snap->sub_count = live;
+	snap->subs = (subscriber_data_t*)(snap + 1);
+	snap->dispatch = (dispatch_entry_t*)(snap->subs + live);
+	snap->next_retired = NULL;
+	memcpy(snap->offsets, offsets, sizeof(offsets));
+
+	size_t copied = 0;
+	for (size_t i = 0; i < count; i++) {
+		if (sub[i].action_mask == 0) {
+			continue;
+		}
+
+		snap->subs[copied++] = sub[i];
+		for (uint64_t mask = sub[i].action_mask; mask != 0; mask &= mask - 1) {
+			dispatch_entry_t* entry = &snap->dispatch[offsets[_lowest_bit(mask)]++];
+			entry->cb = sub[i].cb;
+			entry->cb_extra = sub[i].cb_extra;
+		}
+	}
+
+	obs_snapshot_t* old = atomic_exchange(&obs->snapshot, snap);
+	if (old != NULL) {
+		//readers that saw old announced an epoch <= retire_epoch
+		old->retire_epoch = atomic_fetch_add(&ebr_epoch, 1);
+		old->next_retired = obs->retired;
+		obs->retired = old;
+	}
+
+	_reclaim(obs);
+
+	return OBS_OK;
+}
+
+//on allocation failure lookups fall back to linear scans
+static void _rebuild_lookup(Observer obs) {
+	subscriber_data_t* sub = iLVec.data(obs->subs_data);
+	size_t count = iLVec.size(obs->subs_data);
+
+	obs->allocator->free(obs->lookup);
+	obs->lookup = NULL;
+	obs->lookup_capacity = 0;
+
+	size_t lookup_capacity = 16;
+	while (lookup_capacity < count * 2) {
+		lookup_capacity *= 2;
+	}
+
+	obs->lookup = obs->allocator->calloc(lookup_capacity, sizeof(uint32_t));
+	if (obs->lookup == NULL) {
+		return;
+	}
+	obs->lookup_capacity = lookup_capacity;
+
+	for (size_t i = 0; i < count; i++) {
+		size_t slot = _hash_cb(sub[i].cb, lookup_capacity);
+		while (obs->lookup[slot] != 0) {
+			slot = (slot + 1) & (lookup_capacity - 1);
+		}
+		obs->lookup[slot] = (uint32_t)(i + 1);
+	}
+}
+
+static subscriber_data_t* _find_subscriber(Observer obs, const void* cb) {
+	subscriber_data_t* sub = iLVec.data(obs->subs_data);
+
+	if (obs->lookup == NULL) {
+		for (size_t i = 0; i < iLVec.size(obs->subs_data); i++) {
+			if (cb == sub[i].cb) {
+				return &sub[i];
+			}
+		}
+		return NULL;
+	}
+
+	for (size_t slot = _hash_cb(cb, obs->lookup_capacity); obs->lookup[slot] != 0; slot = (slot + 1) & (obs->lookup_capacity - 1)) {
+		subscriber_data_t* found = &sub[obs->lookup[slot] - 1];
+		if (found->cb == cb) {
+			return found;
+		}
+	}
+
+	return NULL;
+}
+
 static Observer construct(void) {
-	Observer obs = CurrentAllocator->malloc(sizeof(struct Observer_t));
+	const AllocatorInterface* allocator = CurrentAllocator;
+	Observer obs = allocator->malloc(sizeof(struct Observer_t));
 
 	if (obs == NULL) {
 		return NULL;
 	}
 
-	obs->observable_actions = 0;
-	obs->subs_data = iLVec.construct(sizeof(subscriber_data_t));
+	obs->allocator = allocator;
+	atomic_init(&obs->snapshot, NULL);
+	obs->async = NULL;
+	obs->lookup = NULL;
+	obs->lookup_capacity = 0;
+	obs->retired = NULL;
+	obs->subs_data = iLVec.construct_with_allocator(sizeof(subscriber_data_t), obs->allocator);
 
 	if (obs->subs_data == NULL) {
-		CurrentAllocator->free(obs);
+		obs->allocator->free(obs);
 		return NULL;
 	}
 
+	if (mtx_init(&obs->write_lock, mtx_plain) != thrd_success) {
+		iLVec.destruct(obs->subs_data);
+		obs->allocator->free(obs);
+		return NULL;
+	}
+
+	if (_publish(obs) < 0) {
+		mtx_destroy(&obs->write_lock);
+		iLVec.destruct(obs->subs_data);
+		obs->allocator->free(obs);
+		return NULL;
+	}
+
+	_rebuild_lookup(obs);
+
 	return obs;
 }
 
+//no other thread may use obs anymore
 static void destruct(Observer obs) {
 
 	if (obs == NULL) {
 		return;
 	}
 
+	if (obs->async != NULL) {
+		stop_async(obs);
+	}
+
 	subscriber_data_t* sub = iLVec.data(obs->subs_data);
 	for (int i = 0; i < iLVec.size(obs->subs_data); i++) {
 		if (sub[i].auto_free_extra) {
@@ -45,32 +414,38 @@ static void destruct(Observer obs) {
 		}
 	}
 
+	while (obs->retired != NULL) {
+		obs_snapshot_t* next = obs->retired->next_retired;
+		obs->allocator->free(obs->retired);
+		obs->retired = next;
+	}
+
+	obs->allocator->free(atomic_load(&obs->snapshot));
+	obs->allocator->free(obs->lookup);
+	mtx_destroy(&obs->write_lock);
 	iLVec.destruct(obs->subs_data);
-	CurrentAllocator->free(obs);
+	obs->allocator->free(obs);
 }
 
 // -1 - LVec error (memory allocation)
 //	1 - extend callback actions
 //	2 - add new callback
-static int32_t subscribe(Observer obs, uint64_t action_mask, void (*cb)(uint32_t action_flag, const void* call_extra, void* cb_extra), void* cb_extra, int auto_free_extra) {
-
-	if (obs == NULL) {
-		return -1;
-	}
+static int32_t _subscribe(Observer obs, uint64_t action_mask, void (*cb)(uint32_t action_flag, const void* call_extra, void* cb_extra), void* cb_extra, int auto_free_extra) {
 
-	if (action_mask = 0) {
+	if (action_mask == 0) {
 		return OBS_ERR__NULL_ACTION;
 	}
 
-	obs->observable_actions |= action_mask;
-
 	//if we already have this callback -> just extend its action mask
-	subscriber_data_t* data = iLVec.data(obs->subs_data);
-	for (size_t i = 0; i < iLVec.size(obs->subs_data); i++) {
-		if (cb == data[i].cb) {
-			data[i].action_mask |= action_mask;
-			return 1;
+	subscriber_data_t* found = _find_subscriber(obs, cb);
+	if (found != NULL) {
+		uint64_t old_mask = found->action_mask;
+		found->action_mask |= action_mask;
+		if (_publish(obs) < 0) {
+			found->action_mask = old_mask;
+			return OBS_ERR__MALLOC;
 		}
+		return 1;
 	}
 
 	//if haven't this callback yet -> add
@@ -85,67 +460,524 @@ static int32_t subscribe(Observer obs, uint64_t action_mask, void (*cb)(uint32_t
 		return -1;
 	}
 
+	if (_publish(obs) < 0) {
+		iLVec.erase_at(obs->subs_data, iLVec.size(obs->subs_data) - 1);
+		return OBS_ERR__MALLOC;
+	}
+
+	_rebuild_lookup(obs);
+
 	return 2;
 }
 
+//returns cb_extra once the callback has no actions left, readers may still be
+//running it until synchronize returns
+static void* _unsubscribe(Observer obs, uint64_t action_mask, void (*cb)(uint32_t action_flag, const void* call_extra, void* cb_extra)) {
+
+	subscriber_data_t* found = _find_subscriber(obs, cb);
+	if (found == NULL) {
+		return NULL;
+	}
+
+	//a zero mask is left out of the snapshot, so publish before erasing
+	uint64_t old_mask = found->action_mask;
+	found->action_mask &= ~action_mask;
+	if (_publish(obs) < 0) {
+		found->action_mask = old_mask;
+		return NULL;
+	}
+
+	if (found->action_mask != 0) {
+		return NULL;
+	}
+
+	void* extra = found->cb_extra;
+	iLVec.erase_at(obs->subs_data, found - (subscriber_data_t*)iLVec.data(obs->subs_data));
+	_rebuild_lookup(obs);
+
+	return extra;
+}
+
+//runs the callbacks subscribed to action against the current snapshot
+static int32_t _dispatch(Observer obs, int action, void* extra) {
+	int32_t counter = 0;
+
+	ebr_record_t* rec = _ebr_enter();
+	if (rec == NULL) {
+		return OBS_ERR__MALLOC;
+	}
+
+	obs_snapshot_t* snap = atomic_load(&obs->snapshot);
+
+	//single action -> only its own subscribers
+	uint64_t bits = (uint64_t)(uint32_t)action;
+	if ((snap->observable_actions & bits) == 0) {
+		//nothing subscribed
+	}
+	else if ((bits & (bits - 1)) == 0) {
+		uint32_t bit = _lowest_bit(bits);
+		dispatch_entry_t* dispatch = snap->dispatch;
+		uint32_t last = snap->offsets[bit + 1];
+
+		for (uint32_t i = snap->offsets[bit]; i < last; i++) {
+			dispatch[i].cb(action, extra, dispatch[i].cb_extra);
+			counter++;
+		}
+	}
+	else {
+		subscriber_data_t* sub = snap->subs;
+		for (size_t i = 0; i < snap->sub_count; i++) {
+			//action matched with callback action mask
+			if ((sub[i].action_mask & bits) > 0) {
+				sub[i].cb(action, extra, sub[i].cb_extra);
+				counter++;
+			}
+		}
+	}
+
+	_ebr_exit(rec);
+
+	return counter;
+}
+
+static uint64_t _observable_actions(Observer obs) {
+	ebr_record_t* rec = _ebr_enter();
+	if (rec == NULL) {
+		return UINT64_MAX;
+	}
+
+	uint64_t observable_actions = atomic_load(&obs->snapshot)->observable_actions;
+	_ebr_exit(rec);
+
+	return observable_actions;
+}
+
+static int32_t subscribe(Observer obs, uint64_t action_mask, void (*cb)(uint32_t action_flag, const void* call_extra, void* cb_extra), void* cb_extra, int auto_free_extra) {
+
+	if (obs == NULL) {
+		return -1;
+	}
+
+	mtx_lock(&obs->write_lock);
+	int32_t res = _subscribe(obs, action_mask, cb, cb_extra, auto_free_extra);
+	mtx_unlock(&obs->write_lock);
+
+	return res;
+}
+
 static void* unsubscribe(Observer obs, uint64_t action_mask, void (*cb)(uint32_t action_flag, const void* call_extra, void* cb_extra)) {
-	
+
 	if (obs == NULL || cb == NULL || action_mask == 0) {
 		return NULL;
 	}
 
-	uint64_t observable_actions = 0;
-	void* extra = NULL;
+	mtx_lock(&obs->write_lock);
+	void* extra = _unsubscribe(obs, action_mask, cb);
+	mtx_unlock(&obs->write_lock);
 
-	//looking for callback
-	subscriber_data_t* sub = iLVec.data(obs->subs_data);
-	for (int i = 0; i < iLVec.size(obs->subs_data); i++) {
+	return extra;
+}
+
+static int32_t synchronize(Observer obs) {
+	if (obs == NULL) {
+		return OBS_ERR__NULL_OBSERVER;
+	}
+
+	//a callback would wait for its own notify
+	if (ebr_depth > 0) {
+		return OBS_ERR__IN_NOTIFY;
+	}
+
+	uint64_t epoch = atomic_fetch_add(&ebr_epoch, 1);
+	while (_ebr_oldest() <= epoch) {
+		thrd_yield();
+	}
+
+	mtx_lock(&obs->write_lock);
+	_reclaim(obs);
+	mtx_unlock(&obs->write_lock);
+
+	return OBS_OK;
+}
+
+//async delivery
+static void _wake_dispatcher(async_queue_t* queue) {
+	atomic_thread_fence(memory_order_seq_cst);
+	if (atomic_load_explicit(&queue->sleeping, memory_order_relaxed)) {
+		mtx_lock(&queue->wake_lock);
+		cnd_signal(&queue->wake);
+		mtx_unlock(&queue->wake_lock);
+	}
+}
+
+static void _deliver_lock(Observer obs, deliver_hold_t* hold) {
+	mtx_lock(&obs->deliver_lock);
+	hold->obs = obs;
+	hold->prev = deliver_held;
+	deliver_held = hold;
+}
+
+static void _deliver_unlock(deliver_hold_t* hold) {
+	deliver_held = hold->prev;
+	mtx_unlock(&hold->obs->deliver_lock);
+}
+
+static int _holds_deliver_lock(Observer obs) {
+	for (deliver_hold_t* hold = deliver_held; hold != NULL; hold = hold->prev) {
+		if (hold->obs == obs) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+//1 - queued, 0 - queue is full, -1 - extra couldn't be copied and has to be delivered inline
+static int _enqueue(async_queue_t* queue, int action, void* extra) {
+	size_t pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+	async_slot_t* slot;
+
+	for (;;) {
+		slot = &queue->slots[pos & queue->mask];
+		size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+		intptr_t diff = (intptr_t)seq - (intptr_t)pos;
 
-		if (cb == sub[i].cb) {
-			//remove subscribed actions for this callback
-			sub[i].action_mask &= ~action_mask;
-			
-			//if there is no more actions -> remove subscriber
-			if (sub[i].action_mask == 0) {
-				extra = sub[i].cb_extra;
-				iLVec.erase_at(obs->subs_data, i);
-				i--;
-				continue;
+		if (diff == 0) {
+			if (atomic_compare_exchange_weak_explicit(&queue->enqueue_pos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+				break;
 			}
 		}
+		else if (diff < 0) {
+			return 0;
+		}
+		else {
+			pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+		}
+	}
 
-		//if we have some callback on some actions -> set mask accordingly
-		observable_actions |= sub[i].action_mask;
+	slot->action = action;
+	slot->skip = 0;
+	slot->extra = extra;
+	slot->heap = NULL;
+	if (queue->snapshot != NULL && extra != NULL) {
+		size_t used = queue->snapshot(action, extra, slot->snapshot.bytes, OBS_ASYNC_EXTRA_MAX);
+
+		if (used > OBS_ASYNC_EXTRA_MAX && used != OBS_SNAPSHOT_INLINE) {
+			slot->heap = queue->allocator->malloc(used);
+			if (slot->heap == NULL || queue->snapshot(action, extra, slot->heap, used) > used) {
+				used = OBS_SNAPSHOT_INLINE;
+			}
+			else {
+				slot->extra = slot->heap;
+			}
+		}
+		else if (used > 0 && used != OBS_SNAPSHOT_INLINE) {
+			slot->extra = slot->snapshot.bytes;
+		}
+
+		//the claimed slot is still published, so the dispatcher keeps moving
+		if (used == OBS_SNAPSHOT_INLINE) {
+			slot->skip = 1;
+		}
 	}
 
-	obs->observable_actions = observable_actions;
+	int skip = slot->skip;
+	atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+	atomic_fetch_add_explicit(&queue->published, 1, memory_order_release);
 
-	return extra;
+	return skip ? -1 : 1;
 }
 
-static int32_t notify(Observer obs, int action, void* extra) {
+static inline int _slot_ready(async_queue_t* queue, size_t pos) {
+	return atomic_load_explicit(&queue->slots[pos & queue->mask].seq, memory_order_acquire) == pos + 1;
+}
+
+//delivers one queued event, 0 - nothing is ready. Runs on the dispatcher or on a thread
+//that already holds deliver_lock, the lock makes them take turns
+static int _dequeue(Observer obs, async_queue_t* queue) {
+	if (!_slot_ready(queue, atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed))) {
+		return 0;
+	}
+
+	deliver_hold_t hold;
+	_deliver_lock(obs, &hold);
+
+	size_t pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+	if (!_slot_ready(queue, pos)) {
+		_deliver_unlock(&hold);
+		return 0;
+	}
+
+	//moved on before the callbacks run, a drain from inside one takes the next slot
+	atomic_store_explicit(&queue->dequeue_pos, pos + 1, memory_order_relaxed);
+
+	//callbacks read the snapshot straight from the slot
+	async_slot_t* slot = &queue->slots[pos & queue->mask];
+	if (!slot->skip) {
+		_dispatch(obs, slot->action, slot->extra);
+	}
+
+	if (slot->heap != NULL) {
+		queue->allocator->free(slot->heap);
+		slot->heap = NULL;
+	}
+
+	atomic_store_explicit(&slot->seq, pos + queue->mask + 1, memory_order_release);
+	atomic_fetch_add_explicit(&queue->delivered, 1, memory_order_release);
+
+	_deliver_unlock(&hold);
+
+	return 1;
+}
+
+//flush for a thread holding deliver_lock: delivers everything claimed so far on this thread
+static void _drain_owned(Observer obs, async_queue_t* queue) {
+	size_t target = atomic_load_explicit(&queue->enqueue_pos, memory_order_acquire);
+
+	while ((intptr_t)(target - atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed)) > 0) {
+		//another producer is still filling its slot
+		if (!_dequeue(obs, queue)) {
+			thrd_yield();
+		}
+	}
+}
+
+static int _dispatcher(void* arg) {
+	Observer obs = arg;
+	async_queue_t* queue = obs->async;
+
+	for (;;) {
+		if (_dequeue(obs, queue)) {
+			continue;
+		}
+
+		//queue is drained before the thread exits
+		if (atomic_load(&queue->stop)) {
+			break;
+		}
 
-	if ((obs->observable_actions & action) == 0) {
+		mtx_lock(&queue->wake_lock);
+		atomic_store(&queue->sleeping, 1);
+		atomic_thread_fence(memory_order_seq_cst);
+
+		if (!_slot_ready(queue, atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed)) && !atomic_load(&queue->stop)) {
+			struct timespec until;
+			timespec_get(&until, TIME_UTC);
+			until.tv_nsec += 1000000;
+			if (until.tv_nsec >= 1000000000) {
+				until.tv_sec++;
+				until.tv_nsec -= 1000000000;
+			}
+			cnd_timedwait(&queue->wake, &queue->wake_lock, &until);
+		}
+
+		atomic_store(&queue->sleeping, 0);
+		mtx_unlock(&queue->wake_lock);
+	}
+
+	return 0;
+}
+
+static int32_t start_async(Observer obs, const obs_async_config_t* config) {
+	if (obs == NULL) {
+		return OBS_ERR__NULL_OBSERVER;
+	}
+
+	if (obs->async != NULL) {
+		return OBS_ERR__ASYNC_RUNNING;
+	}
+
+	obs_async_config_t cfg = { 0, OBS_ASYNC__BLOCK, NULL };
+	if (config != NULL) {
+		cfg = *config;
+	}
+
+	size_t capacity = 2;
+	while (capacity < (cfg.capacity == 0 ? OBS_ASYNC_DEFAULT_CAPACITY : cfg.capacity)) {
+		capacity *= 2;
+	}
+
+	async_queue_t* queue = obs->allocator->malloc(sizeof(async_queue_t));
+	if (queue == NULL) {
+		return OBS_ERR__MALLOC;
+	}
+
+	queue->slots = obs->allocator->malloc(capacity * sizeof(async_slot_t));
+	if (queue->slots == NULL) {
+		obs->allocator->free(queue);
+		return OBS_ERR__MALLOC;
+	}
+
+	for (size_t i = 0; i < capacity; i++) {
+		atomic_init(&queue->slots[i].seq, i);
+	}
+
+	queue->mask = capacity - 1;
+	queue->allocator = obs->allocator;
+	queue->policy = cfg.policy;
+	queue->snapshot = cfg.snapshot;
+	atomic_init(&queue->enqueue_pos, 0);
+	atomic_init(&queue->dequeue_pos, 0);
+	atomic_init(&queue->published, 0);
+	atomic_init(&queue->delivered, 0);
+	atomic_init(&queue->dropped, 0);
+	atomic_init(&queue->sleeping, 0);
+	atomic_init(&queue->stop, 0);
+	if (mtx_init(&queue->wake_lock, mtx_plain) != thrd_success) {
+		obs->allocator->free(queue->slots);
+		obs->allocator->free(queue);
+		return OBS_ERR__THREAD;
+	}
+
+	if (cnd_init(&queue->wake) != thrd_success) {
+		mtx_destroy(&queue->wake_lock);
+		obs->allocator->free(queue->slots);
+		obs->allocator->free(queue);
+		return OBS_ERR__THREAD;
+	}
+
+	//recursive: a callback may notify with a full queue and deliver inline
+	if (mtx_init(&obs->deliver_lock, mtx_plain | mtx_recursive) != thrd_success) {
+		cnd_destroy(&queue->wake);
+		mtx_destroy(&queue->wake_lock);
+		obs->allocator->free(queue->slots);
+		obs->allocator->free(queue);
+		return OBS_ERR__THREAD;
+	}
+
+	obs->async = queue;
+
+	if (thrd_create(&queue->thread, _dispatcher, obs) != thrd_success) {
+		obs->async = NULL;
+		mtx_destroy(&obs->deliver_lock);
+		mtx_destroy(&queue->wake_lock);
+		cnd_destroy(&queue->wake);
+		obs->allocator->free(queue->slots);
+		obs->allocator->free(queue);
+		return OBS_ERR__THREAD;
+	}
+
+	return OBS_OK;
+}
+
+static int32_t stop_async(Observer obs) {
+	if (obs == NULL) {
+		return OBS_ERR__NULL_OBSERVER;
+	}
+
+	async_queue_t* queue = obs->async;
+	if (queue == NULL) {
+		return OBS_OK;
+	}
+
+	atomic_store(&queue->stop, 1);
+	mtx_lock(&queue->wake_lock);
+	cnd_signal(&queue->wake);
+	mtx_unlock(&queue->wake_lock);
+	thrd_join(queue->thread, NULL);
+
+	obs->async = NULL;
+	mtx_destroy(&obs->deliver_lock);
+	mtx_destroy(&queue->wake_lock);
+	cnd_destroy(&queue->wake);
+	obs->allocator->free(queue->slots);
+	obs->allocator->free(queue);
+
+	return OBS_OK;
+}
+
+static int32_t flush(Observer obs) {
+	if (obs == NULL) {
+		return OBS_ERR__NULL_OBSERVER;
+	}
+
+	async_queue_t* queue = obs->async;
+	if (queue == NULL) {
+		return OBS_OK;
+	}
+
+	//the dispatcher waits for deliver_lock, a callback or an inline delivery can't wait for it
+	if (_holds_deliver_lock(obs)) {
+		_drain_owned(obs, queue);
+		return OBS_OK;
+	}
+
+	if (thrd_equal(thrd_current(), queue->thread)) {
+		return OBS_OK;
+	}
+
+	size_t target = atomic_load_explicit(&queue->published, memory_order_acquire);
+	while (atomic_load_explicit(&queue->delivered, memory_order_acquire) < target) {
+		_wake_dispatcher(queue);
+		thrd_yield();
+	}
+
+	return OBS_OK;
+}
+
+static uint64_t dropped(const Observer obs) {
+	if (obs == NULL || obs->async == NULL) {
 		return 0;
 	}
 
+	return atomic_load(&obs->async->dropped);
+}
+
+static int32_t notify(Observer obs, int action, void* extra) {
+
 	if (obs == NULL) {
 		return OBS_ERR__NULL_OBSERVER;
 	}
 
+	async_queue_t* queue = obs->async;
+	if (queue == NULL) {
+		return _dispatch(obs, action, extra);
+	}
 
-	int32_t counter = 0;
-	//looking for callback
-	subscriber_data_t* sub = iLVec.data(obs->subs_data);
-	for (int i = 0; i < iLVec.size(obs->subs_data); i++) {
-		//action matched with callback action mask
-		if ((sub[i].action_mask & action) > 0) {
-			sub[i].cb(action, extra, sub[i].cb_extra);
-			counter++;
+	if ((_observable_actions(obs) & (uint64_t)(uint32_t)action) == 0) {
+		return 0;
+	}
+
+	//async: callbacks run later on the dispatcher, nothing was called yet
+	int queued;
+	while ((queued = _enqueue(queue, action, extra)) == 0) {
+		if (queue->policy == OBS_ASYNC__DROP) {
+			atomic_fetch_add(&queue->dropped, 1);
+			return OBS_ERR__DROPPED;
 		}
+
+		//a deliver_lock holder (the dispatcher in a callback too) makes room itself, the slot
+		//of the event it is inside of stays taken, so past that it delivers inline
+		int owner = _holds_deliver_lock(obs);
+		if (owner && _dequeue(obs, queue)) {
+			continue;
+		}
+
+		if (queue->policy == OBS_ASYNC__INLINE || owner || thrd_equal(thrd_current(), queue->thread)) {
+			deliver_hold_t hold;
+			_deliver_lock(obs, &hold);
+			int32_t counter = _dispatch(obs, action, extra);
+			_deliver_unlock(&hold);
+			return counter;
+		}
+
+		_wake_dispatcher(queue);
+		thrd_yield();
 	}
 
-	return counter;
+	//extra only lives until we return: deliver it here, after what was queued before it
+	if (queued < 0) {
+		flush(obs);
+		deliver_hold_t hold;
+		_deliver_lock(obs, &hold);
+		int32_t counter = _dispatch(obs, action, extra);
+		_deliver_unlock(&hold);
+		return counter;
+	}
+
+	_wake_dispatcher(queue);
+
+	return 0;
 }
 
 ObserverInterface_t iObserver = {
@@ -153,6 +985,11 @@ ObserverInterface_t iObserver = {
 	.destruct = destruct,
 	.notify = notify,
 	.subscribe = subscribe,
-	.unsubscribe = unsubscribe
+	.unsubscribe = unsubscribe,
+	.synchronize = synchronize,
+	.start_async = start_async,
+	.stop_async = stop_async,
+	.flush = flush,
+	.dropped = dropped
 };
 
@@ -0,0 +1,295 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include "allocator_i.h"
+#include "pool_allocator_i.h"
+
+#define POOL_ALIGNMENT			16
+#define POOL_ALIGN_UP(n)		(((n) + (POOL_ALIGNMENT - 1)) & ~((size_t)POOL_ALIGNMENT - 1))
+#define POOL_LARGE_CLASS		UINT32_MAX
+
+//header in front of every block, tells free() where the block goes back to
+typedef struct {
+  uint32_t  size_class;
+} pool_header_t;
+
+#define POOL_HEADER_SIZE		POOL_ALIGN_UP(sizeof(pool_header_t))
+
+typedef struct pool_free_block_t {
+  struct pool_free_block_t* next;
+} pool_free_block_t;
+
+typedef struct {
+  pool_free_block_t*  free_list[POOL_CLASS_COUNT];
+  size_t              free_count[POOL_CLASS_COUNT];
+  char*               slab_cursor;
+  char*               slab_end;
+  size_t              slab_bytes;
+} pool_thread_cache_t;
+
+static ALLOCATOR_THREAD_LOCAL pool_thread_cache_t thread_cache;
+
+//blocks released by threads with full caches, shared by everybody
+static pool_free_block_t* depot[POOL_CLASS_COUNT];
+static size_t depot_count[POOL_CLASS_COUNT];
+static atomic_flag depot_lock = ATOMIC_FLAG_INIT;
+
+static void _depot_lock(void) {
+  while (atomic_flag_test_and_set_explicit(&depot_lock, memory_order_acquire)) {
+  }
+}
+
+static void _depot_unlock(void) {
+  atomic_flag_clear_explicit(&depot_lock, memory_order_release);
+}
+
+static uint32_t _size_class(size_t size) {
+  if (size > POOL_MAX_BLOCK_SIZE) {
+    return POOL_LARGE_CLASS;
+  }
+
+  uint32_t cls = 0;
+  while (((size_t)1 << (cls + POOL_MIN_BLOCK_SHIFT)) < size) {
+    cls++;
+  }
+
+  return cls;
+}
+
+static size_t _class_size(uint32_t cls) {
+  return (size_t)1 << (cls + POOL_MIN_BLOCK_SHIFT);
+}
+
+static pool_header_t* _header(void* ptr) {
+  return (pool_header_t*)((char*)ptr - POOL_HEADER_SIZE);
+}
+
+//move up to count blocks from this thread's list into the depot
+static void _flush_class(uint32_t cls, size_t count) {
+  pool_thread_cache_t* cache = &thread_cache;
+
+  if (count == 0 || cache->free_list[cls] == NULL) {
+    return;
+  }
+
+  pool_free_block_t* first = cache->free_list[cls];
+  pool_free_block_t* last = first;
+  size_t moved = 1;
+
+  while (moved < count && last->next != NULL) {
+    last = last->next;
+    moved++;
+  }
+
+  cache->free_list[cls] = last->next;
+  cache->free_count[cls] -= moved;
+
+  _depot_lock();
+  last->next = depot[cls];
+  depot[cls] = first;
+  depot_count[cls] += moved;
+  _depot_unlock();
+}
+
+static int32_t _refill_from_depot(uint32_t cls) {
+  pool_thread_cache_t* cache = &thread_cache;
+  pool_free_block_t* first = NULL;
+  size_t taken = 0;
+
+  _depot_lock();
+  first = depot[cls];
+  if (first != NULL) {
+    pool_free_block_t* last = first;
+    taken = 1;
+
+    while (taken < POOL_BATCH_SIZE && last->next != NULL) {
+      last = last->next;
+      taken++;
+    }
+
+    depot[cls] = last->next;
+    depot_count[cls] -= taken;
+    last->next = cache->free_list[cls];
+  }
+  _depot_unlock();
+
+  if (taken == 0) {
+    return -1;
+  }
+
+  cache->free_list[cls] = first;
+  cache->free_count[cls] += taken;
+
+  return 0;
+}
+
+static int32_t _refill_from_slab(uint32_t cls) {
+  pool_thread_cache_t* cache = &thread_cache;
+  size_t stride = POOL_HEADER_SIZE + _class_size(cls);
+
+  for (size_t i = 0; i < POOL_BATCH_SIZE; i++) {
+    if ((size_t)(cache->slab_end - cache->slab_cursor) < stride) {
+      //tail of the old slab is abandoned, it is smaller than one block of this class
+      if (i > 0) {
+        break;
+      }
+
+      char* slab = DefaultAllocator.malloc(POOL_SLAB_SIZE);
+      if (slab == NULL) {
+        return -1;
+      }
+
+      cache->slab_cursor = slab;
+      cache->slab_end = slab + POOL_SLAB_SIZE;
+      cache->slab_bytes += POOL_SLAB_SIZE;
+    }
+
+    pool_header_t* header = (pool_header_t*)cache->slab_cursor;
+    header->size_class = cls;
+    cache->slab_cursor += stride;
+
+    pool_free_block_t* block = (pool_free_block_t*)((char*)header + POOL_HEADER_SIZE);
+    block->next = cache->free_list[cls];
+    cache->free_list[cls] = block;
+    cache->free_count[cls]++;
+  }
+
+  return 0;
+}
+
+//AllocatorInterface
+static void* pool_malloc(size_t size) {
+  uint32_t cls = _size_class(size);
+
+  if (cls == POOL_LARGE_CLASS) {
+    pool_header_t* header = DefaultAllocator.malloc(POOL_HEADER_SIZE + size);
+    if (header == NULL) {
+      return NULL;
+    }
+
+    header->size_class = POOL_LARGE_CLASS;
+    return (char*)header + POOL_HEADER_SIZE;
+  }
+
+  pool_thread_cache_t* cache = &thread_cache;
+
+  if (cache->free_list[cls] == NULL) {
+    if (_refill_from_depot(cls) < 0 && _refill_from_slab(cls) < 0) {
+      return NULL;
+    }
+  }
+
+  pool_free_block_t* block = cache->free_list[cls];
+  cache->free_list[cls] = block->next;
+  cache->free_count[cls]--;
+
+  return block;
+}
+
+static void pool_free(void* ptr) {
+  if (ptr == NULL) {
+    return;
+  }
+
+  pool_header_t* header = _header(ptr);
+  uint32_t cls = header->size_class;
+
+  if (cls == POOL_LARGE_CLASS) {
+    DefaultAllocator.free(header);
+    return;
+  }
+
+  //blocks freed on another thread simply join this thread's cache
+  pool_thread_cache_t* cache = &thread_cache;
+  pool_free_block_t* block = ptr;
+
+  block->next = cache->free_list[cls];
+  cache->free_list[cls] = block;
+  cache->free_count[cls]++;
+
+  if (cache->free_count[cls] > POOL_THREAD_CACHE_LIMIT) {
+    _flush_class(cls, POOL_THREAD_CACHE_LIMIT / 2);
+  }
+}
+
+static void* pool_realloc(void* ptr, size_t size) {
+  if (ptr == NULL) {
+    return pool_malloc(size);
+  }
+
+  pool_header_t* header = _header(ptr);
+  uint32_t cls = header->size_class;
+  uint32_t new_cls = _size_class(size);
+
+  if (cls == POOL_LARGE_CLASS && new_cls == POOL_LARGE_CLASS) {
+    pool_header_t* tmp = DefaultAllocator.realloc(header, POOL_HEADER_SIZE + size);
+    if (tmp == NULL) {
+      return NULL;
+    }
+
+    return (char*)tmp + POOL_HEADER_SIZE;
+  }
+
+  //still fits the same block
+  if (cls != POOL_LARGE_CLASS && new_cls <= cls) {
+    return ptr;
+  }
+
+  void* new_ptr = pool_malloc(size);
+  if (new_ptr == NULL) {
+    return NULL;
+  }
+
+  size_t old_size = cls == POOL_LARGE_CLASS ? size : _class_size(cls);
+  memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+  pool_free(ptr);
+
+  return new_ptr;
+}
+
+static void* pool_calloc(size_t count, size_t size) {
+  if (size != 0 && count > (size_t)-1 / size) {
+    return NULL;
+  }
+
+  void* ptr = pool_malloc(count * size);
+  if (ptr != NULL) {
+    memset(ptr, 0, count * size);
+  }
+
+  return ptr;
+}
+
+//PoolInterface
+static size_t block_size(size_t size) {
+  uint32_t cls = _size_class(size);
+  return cls == POOL_LARGE_CLASS ? size : _class_size(cls);
+}
+
+//hand every cached block to the depot, call it before a thread exits
+static void flush_thread_cache(void) {
+  for (uint32_t cls = 0; cls < POOL_CLASS_COUNT; cls++) {
+    _flush_class(cls, thread_cache.free_count[cls]);
+  }
+}
+
+static void thread_stats(pool_thread_stats_t* stats) {
+  if (stats == NULL) {
+    return;
+  }
+
+  for (uint32_t cls = 0; cls < POOL_CLASS_COUNT; cls++) {
+    stats->cached_blocks[cls] = thread_cache.free_count[cls];
+  }
+
+  stats->slab_bytes = thread_cache.slab_bytes;
+}
+
+AllocatorInterface PoolAllocator = { pool_malloc, pool_free, pool_realloc, pool_calloc };
+
+PoolInterface_t iPool = {
+  .block_size = block_size,
+  .flush_thread_cache = flush_thread_cache,
+  .thread_stats = thread_stats
+};
@@ -0,0 +1,312 @@
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#include "allocator_i.h"
+#include "psort_i.h"
+#include "tpool_i.h"
+
+#define PSORT_INSERTION_THRESHOLD		16
+
+typedef int32_t (*psort_cmp_fn)(const void* first, const void* second);
+
+typedef struct {
+  //chunk sort
+  char*         base;
+  char*         tmp;
+  size_t        count;
+  int           stable;
+
+  //merge of src[a_begin, a_end) and src[b_begin, b_end) into dst[out]
+  const char*   src;
+  char*         dst;
+  size_t        a_begin;
+  size_t        a_end;
+  size_t        b_begin;
+  size_t        b_end;
+  size_t        out;
+
+  size_t        elem_size;
+  psort_cmp_fn  cmp;
+} psort_task_t;
+
+static void _insertion_sort(char* base, size_t count, size_t elem_size, psort_cmp_fn cmp, char* scratch) {
+  for (size_t i = 1; i < count; i++) {
+    char* elem = base + (i * elem_size);
+    size_t j = i;
+
+    while (j > 0 && cmp(elem, base + ((j - 1) * elem_size)) < 0) {
+      j--;
+    }
+
+    if (j != i) {
+      memcpy(scratch, elem, elem_size);
+      memmove(base + ((j + 1) * elem_size), base + (j * elem_size), (i - j) * elem_size);
+      memcpy(base + (j * elem_size), scratch, elem_size);
+    }
+  }
+}
+
+//stable: on equal elements the one from a goes first
+static void _merge(const char* a, size_t a_count, const char* b, size_t b_count, char* out, size_t elem_size, psort_cmp_fn cmp) {
+  const char* a_end = a + (a_count * elem_size);
+  const char* b_end = b + (b_count * elem_size);
+
+  while (a < a_end && b < b_end) {
+    if (cmp(b, a) < 0) {
+      memcpy(out, b, elem_size);
+      b += elem_size;
+    }
+    else {
+      memcpy(out, a, elem_size);
+      a += elem_size;
+    }
+    out += elem_size;
+  }
+
+  memcpy(out, a, a_end - a);
+  out += a_end - a;
+  memcpy(out, b, b_end - b);
+}
+
+//tmp is scratch space of the same size as base
+static void _merge_sort(char* base, char* tmp, size_t count, size_t elem_size, psort_cmp_fn cmp) {
+  if (count <= PSORT_INSERTION_THRESHOLD) {
+    _insertion_sort(base, count, elem_size, cmp, tmp);
+    return;
+  }
+
+  size_t half = count / 2;
+  char* second = base + (half * elem_size);
+
+  _merge_sort(base, tmp, half, elem_size, cmp);
+  _merge_sort(second, tmp + (half * elem_size), count - half, elem_size, cmp);
+
+  //halves already in order
+  if (cmp(second - elem_size, second) <= 0) {
+    return;
+  }
+
+  memcpy(tmp, base, count * elem_size);
+  _merge(tmp, half, tmp + (half * elem_size), count - half, base, elem_size, cmp);
+}
+
+static size_t _lower_bound(const char* base, size_t first, size_t last, const void* elem, size_t elem_size, psort_cmp_fn cmp) {
+  while (first < last) {
+    size_t mid = first + (last - first) / 2;
+    if (cmp(base + (mid * elem_size), elem) < 0) {
+      first = mid + 1;
+    }
+    else {
+      last = mid;
+    }
+  }
+  return first;
+}
+
+static size_t _upper_bound(const char* base, size_t first, size_t last, const void* elem, size_t elem_size, psort_cmp_fn cmp) {
+  while (first < last) {
+    size_t mid = first + (last - first) / 2;
+    if (cmp(elem, base + (mid * elem_size)) >= 0) {
+      first = mid + 1;
+    }
+    else {
+      last = mid;
+    }
+  }
+  return first;
+}
+
+static int _chunk_task(void* arg) {
+  psort_task_t* task = arg;
+
+  if (task->stable) {
+    _merge_sort(task->base, task->tmp, task->count, task->elem_size, task->cmp);
+  }
+  else {
+    qsort(task->base, task->count, task->elem_size, task->cmp);
+  }
+
+  return 0;
+}
+
+static int _merge_task(void* arg) {
+  psort_task_t* task = arg;
+  size_t elem_size = task->elem_size;
+
+  _merge(task->src + (task->a_begin * elem_size), task->a_end - task->a_begin,
+    task->src + (task->b_begin * elem_size), task->b_end - task->b_begin,
+    task->dst + (task->out * elem_size), elem_size, task->cmp);
+
+  return 0;
+}
+
+//last task runs on the calling thread, a task whose thread can't start runs inline too
+static void _run_tasks(psort_task_t* tasks, size_t count, int (*fn)(void*)) {
+  thrd_t threads[PSORT_MAX_THREADS];
+  int started[PSORT_MAX_THREADS];
+
+  for (size_t i = 0; i + 1 < count; i++) {
+    started[i] = thrd_create(&threads[i], fn, &tasks[i]) == thrd_success;
+    if (!started[i]) {
+      fn(&tasks[i]);
+    }
+  }
+
+  fn(&tasks[count - 1]);
+
+  for (size_t i = 0; i + 1 < count; i++) {
+    if (started[i]) {
+      thrd_join(threads[i], NULL);
+    }
+  }
+}
+
+static size_t hardware_threads(void) {
+  return iThreadPool.hardware_threads();
+}
+
+static int32_t sort(void* base, size_t count, size_t elem_size, psort_cmp_fn cmp, const psort_config_t* config) {
+  psort_config_t cfg = { 0, 0, 0 };
+
+  if (cmp == NULL) {
+    return PSORT_ERR__NULL_CMP_FN;
+  }
+
+  if (base == NULL && count > 0) {
+    return PSORT_ERR__NULL_DATA;
+  }
+
+  if (config != NULL) {
+    cfg = *config;
+  }
+
+  size_t cutoff = cfg.cutoff == 0 ? PSORT_DEFAULT_CUTOFF : cfg.cutoff;
+  size_t threads = cfg.threads == 0 ? hardware_threads() : cfg.threads;
+  if (threads > PSORT_MAX_THREADS) {
+    threads = PSORT_MAX_THREADS;
+  }
+
+  //pairwise merging wants a power of two number of runs
+  size_t runs = 1;
+  while (runs * 2 <= threads) {
+    runs *= 2;
+  }
+
+  if (count < 2) {
+    return PSORT_OK;
+  }
+
+  if (!cfg.stable && (count < cutoff || runs == 1)) {
+    qsort(base, count, elem_size, cmp);
+    return PSORT_OK;
+  }
+
+  char* tmp = CurrentAllocator->malloc(count * elem_size);
+  if (tmp == NULL) {
+    return PSORT_ERR__MALLOC;
+  }
+
+  if (count < cutoff || runs == 1) {
+    _merge_sort(base, tmp, count, elem_size, cmp);
+    CurrentAllocator->free(tmp);
+    return PSORT_OK;
+  }
+
+  psort_task_t tasks[PSORT_MAX_THREADS];
+  size_t bounds[PSORT_MAX_THREADS + 1];
+
+  //sort chunks
+  for (size_t i = 0; i <= runs; i++) {
+    bounds[i] = (count * i) / runs;
+  }
+
+  for (size_t i = 0; i < runs; i++) {
+    psort_task_t* task = &tasks[i];
+    task->base = (char*)base + (bounds[i] * elem_size);
+    task->tmp = tmp + (bounds[i] * elem_size);
+    task->count = bounds[i + 1] - bounds[i];
+    task->stable = cfg.stable;
+    task->elem_size = elem_size;
+    task->cmp = cmp;
+  }
+
+  _run_tasks(tasks, runs, _chunk_task);
+
+  //merge runs pairwise, each pair is split between runs / pairs threads
+  char* src = base;
+  char* dst = tmp;
+  size_t run_count = runs;
+
+  while (run_count > 1) {
+    size_t pairs = run_count / 2;
+    size_t pieces = runs / pairs;
+    size_t task_count = 0;
+
+    for (size_t p = 0; p < pairs; p++) {
+      size_t a_begin = bounds[2 * p];
+      size_t a_end = bounds[2 * p + 1];
+      size_t b_begin = a_end;
+      size_t b_end = bounds[2 * p + 2];
+      int split_a = (a_end - a_begin) >= (b_end - b_begin);
+
+      size_t a_prev = a_begin;
+      size_t b_prev = b_begin;
+
+      for (size_t k = 1; k <= pieces; k++) {
+        size_t a_next = a_end;
+        size_t b_next = b_end;
+
+        //split the longer run evenly and find the matching point in the other one
+        if (k < pieces) {
+          if (split_a) {
+            a_next = a_begin + ((a_end - a_begin) * k) / pieces;
+            b_next = a_next < a_end ? _lower_bound(src, b_begin, b_end, src + (a_next * elem_size), elem_size, cmp) : b_end;
+          }
+          else {
+            b_next = b_begin + ((b_end - b_begin) * k) / pieces;
+            a_next = b_next < b_end ? _upper_bound(src, a_begin, a_end, src + (b_next * elem_size), elem_size, cmp) : a_end;
+          }
+        }
+
+        psort_task_t* task = &tasks[task_count++];
+        task->src = src;
+        task->dst = dst;
+        task->a_begin = a_prev;
+        task->a_end = a_next;
+        task->b_begin = b_prev;
+        task->b_end = b_next;
+        task->out = a_begin + (a_prev - a_begin) + (b_prev - b_begin);
+        task->elem_size = elem_size;
+        task->cmp = cmp;
+
+        a_prev = a_next;
+        b_prev = b_next;
+      }
+    }
+
+    _run_tasks(tasks, task_count, _merge_task);
+
+    for (size_t p = 0; p <= pairs; p++) {
+      bounds[p] = bounds[2 * p];
+    }
+    run_count = pairs;
+
+    char* swap = src;
+    src = dst;
+    dst = swap;
+  }
+
+  if (src != base) {
+    memcpy(base, src, count * elem_size);
+  }
+
+  CurrentAllocator->free(tmp);
+
+  return PSORT_OK;
+}
+
+PSortInterface_t iPSort = {
+  .sort = sort,
+  .hardware_threads = hardware_threads
+};
@@ -0,0 +1,524 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include "allocator_i.h"
+#include "observer_i.h"
+#include "ring_i.h"
+
+//head and tail only grow (push_front/pop_back step them back), size is tail - head and
+//position p lives at data[p & mask]. In SPSC mode the consumer owns head, the producer tail.
+struct tagRingBuffer {
+  size_t                    elem_size;
+  size_t                    capacity;
+  size_t                    mask;
+  char*                     data;
+  uint32_t                  flags;
+  atomic_uint               error;
+
+  const AllocatorInterface* allocator;
+  void                      (*elem_destructor)(void* elem);
+  Observer                  observer;
+
+  //producer and consumer counters on their own cache lines
+  char                      pad_head[64];
+  atomic_size_t             head;
+  char                      pad_tail[64 - sizeof(atomic_size_t)];
+  atomic_size_t             tail;
+  char                      pad_end[64 - sizeof(atomic_size_t)];
+};
+
+static inline int32_t _fail(Ring r, int32_t error) {
+  atomic_store_explicit(&r->error, (uint32_t)error, memory_order_relaxed);
+  return error;
+}
+
+static void _spans(const Ring r, size_t start, size_t count, ring_spans_t* spans) {
+  size_t offset = start & r->mask;
+  size_t first = r->capacity - offset;
+  if (first > count) {
+    first = count;
+  }
+
+  spans->first.data = count > 0 ? r->data + (offset * r->elem_size) : NULL;
+  spans->first.count = first;
+  spans->second.data = count > first ? r->data : NULL;
+  spans->second.count = count - first;
+}
+
+static void _copy_in(Ring r, size_t start, const char* src, size_t count) {
+  if (count == 0) {
+    return;
+  }
+
+  ring_spans_t spans;
+  _spans(r, start, count, &spans);
+
+  memcpy(spans.first.data, src, spans.first.count * r->elem_size);
+  if (spans.second.count > 0) {
+    memcpy(spans.second.data, src + (spans.first.count * r->elem_size), spans.second.count * r->elem_size);
+  }
+}
+
+static void _copy_out(const Ring r, size_t start, char* dst, size_t count) {
+  if (count == 0) {
+    return;
+  }
+
+  ring_spans_t spans;
+  _spans(r, start, count, &spans);
+
+  memcpy(dst, spans.first.data, spans.first.count * r->elem_size);
+  if (spans.second.count > 0) {
+    memcpy(dst + (spans.first.count * r->elem_size), spans.second.data, spans.second.count * r->elem_size);
+  }
+}
+
+static void _destroy(Ring r, size_t start, size_t count) {
+  if (r->elem_destructor == NULL) {
+    return;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    r->elem_destructor(r->data + (((start + i) & r->mask) * r->elem_size));
+  }
+}
+
+//callbacks see the elements while they are still in place
+static void _notify(Ring r, int action, size_t start, size_t count) {
+  if (r->observer == NULL) {
+    return;
+  }
+
+  ring_action_extra_t extra = { .ring = r, .count = count };
+  _spans(r, start, count, &extra.spans);
+  iObserver.notify(r->observer, action, &extra);
+}
+
+//live cycle
+static Ring construct_with_allocator(size_t elem_size, size_t capacity, uint32_t flags, const AllocatorInterface* allocator) {
+  if (elem_size == 0 || capacity == 0) {
+    return NULL;
+  }
+
+  //overwriting moves head, which the producer doesn't own in SPSC mode
+  if ((flags & RING_FLAG__SPSC) && (flags & RING_FLAG__OVERWRITE)) {
+    return NULL;
+  }
+
+  if (allocator == NULL) {
+    allocator = CurrentAllocator;
+  }
+
+  size_t rounded = 1;
+  while (rounded < capacity) {
+    rounded *= 2;
+  }
+
+  Ring r = allocator->malloc(sizeof(struct tagRingBuffer));
+  if (r == NULL) {
+    return NULL;
+  }
+
+  r->data = allocator->malloc(rounded * elem_size);
+  if (r->data == NULL) {
+    allocator->free(r);
+    return NULL;
+  }
+
+  r->elem_size = elem_size;
+  r->capacity = rounded;
+  r->mask = rounded - 1;
+  r->flags = flags;
+  r->allocator = allocator;
+  r->elem_destructor = NULL;
+  r->observer = NULL;
+  atomic_init(&r->error, RING_OK);
+  atomic_init(&r->head, 0);
+  atomic_init(&r->tail, 0);
+
+  return r;
+}
+
+static Ring construct(size_t elem_size, size_t capacity, uint32_t flags) {
+  return construct_with_allocator(elem_size, capacity, flags, NULL);
+}
+
+static int32_t destruct(Ring r) {
+  if (r == NULL) {
+    return RING_ERR__NULL_RING;
+  }
+
+  size_t head = atomic_load(&r->head);
+  size_t count = atomic_load(&r->tail) - head;
+
+  _notify(r, RING_ACTION__DESTRUCT, head, count);
+  _destroy(r, head, count);
+
+  iObserver.destruct(r->observer);
+  r->allocator->free(r->data);
+  r->allocator->free(r);
+
+  return RING_OK;
+}
+
+//info
+static size_t size(const Ring r) {
+  if (r == NULL) {
+    return 0;
+  }
+
+  size_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+  return atomic_load_explicit(&r->tail, memory_order_acquire) - head;
+}
+
+static size_t capacity(const Ring r) {
+  return r != NULL ? r->capacity : 0;
+}
+
+static size_t elem_size(const Ring r) {
+  return r != NULL ? r->elem_size : 0;
+}
+
+static uint32_t get_flags(const Ring r) {
+  return r != NULL ? r->flags : 0;
+}
+
+static uint32_t error(const Ring r) {
+  return r != NULL ? atomic_load_explicit(&r->error, memory_order_relaxed) : (uint32_t)RING_ERR__NULL_RING;
+}
+
+static int32_t set_elem_destructor(Ring r, void (*cb)(void* elem)) {
+  if (r == NULL) {
+    return RING_ERR__NULL_RING;
+  }
+
+  r->elem_destructor = cb;
+  return RING_OK;
+}
+
+//single elements
+static int32_t push_back(Ring r, const void* elem) {
+  if (r == NULL) {
+    return RING_ERR__NULL_RING;
+  }
+
+  if (elem == NULL) {
+    return _fail(r, RING_ERR__NULL_ELEM);
+  }
+
+  size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+  size_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+
+  if (tail - head == r->capacity) {
+    if (!(r->flags & RING_FLAG__OVERWRITE)) {
+      return _fail(r, RING_ERR__FULL);
+    }
+
+    _notify(r, RING_ACTION__OVERWRITE, head, 1);
+    _destroy(r, head, 1);
+    atomic_store_explicit(&r->head, head + 1, memory_order_relaxed);
+  }
+
+  memcpy(r->data + ((tail & r->mask) * r->elem_size), elem, r->elem_size);
+  _notify(r, RING_ACTION__PUSH, tail, 1);
+  atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+
+  return RING_OK;
+}
+
+static int32_t push_front(Ring r, const void* elem) {
+  if (r == NULL) {
+    return RING_ERR__NULL_RING;
+  }
+
+  if (r->flags & RING_FLAG__SPSC) {
+    return _fail(r, RING_ERR__MODE);
+  }
+
+  if (elem == NULL) {
+    return _fail(r, RING_ERR__NULL_ELEM);
+  }
+
+  size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+  if (tail - head == r->capacity) {
+    if (!(r->flags & RING_FLAG__OVERWRITE)) {
+      return _fail(r, RING_ERR__FULL);
+    }
+
+    tail--;
+    _notify(r, RING_ACTION__OVERWRITE, tail, 1);
+    _destroy(r, tail, 1);
+    atomic_store_explicit(&r->tail, tail, memory_order_relaxed);
+  }
+
+  head--;
+  memcpy(r->data + ((head & r->mask) * r->elem_size), elem, r->elem_size);
+  _notify(r, RING_ACTION__PUSH, head, 1);
+  atomic_store_explicit(&r->head, head, memory_order_relaxed);
+
+  return RING_OK;
+}
+
+static int32_t pop_front(Ring r, void* out) {
+  if (r == NULL) {
+    return RING_ERR__NULL_RING;
+  }
+
+  size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+
+  if (tail == head) {
+    return _fail(r, RING_ERR__EMPTY);
+  }
+
+  char* ptr = r->data + ((head & r->mask) * r->elem_size);
+  _notify(r, RING_ACTION__POP, head, 1);
+  if (out != NULL) {
+    memcpy(out, ptr, r->elem_size);
+  }
+  else {
+    _destroy(r, head, 1);
+  }
+  atomic_store_explicit(&r->head, head + 1, memory_order_release);
+
+  return RING_OK;
+}
+
+static int32_t pop_back(Ring r, void* out) {
+  if (r == NULL) {
+    return RING_ERR__NULL_RING;
+  }
+
+  if (r->flags & RING_FLAG__SPSC) {
+    return _fail(r, RING_ERR__MODE);
+  }
+
+  size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+  if (tail == head) {
+    return _fail(r, RING_ERR__EMPTY);
+  }
+
+  tail--;
+  char* ptr = r->data + ((tail & r->mask) * r->elem_size);
+  _notify(r, RING_ACTION__POP, tail, 1);
+  if (out != NULL) {
+    memcpy(out, ptr, r->elem_size);
+  }
+  else {
+    _destroy(r, tail, 1);
+  }
+  atomic_store_explicit(&r->tail, tail, memory_order_relaxed);
+
+  return RING_OK;
+}
+
+//consumer side in SPSC mode
+static int32_t clear(Ring r) {
+  if (r == NULL) {
+    return RING_ERR__NULL_RING;
+  }
+
+  size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+
+  _notify(r, RING_ACTION__CLEAR, head, tail - head);
+  _destroy(r, head, tail - head);
+  atomic_store_explicit(&r->head, tail, memory_order_release);
+
+  return RING_OK;
+}
+
+//bulk
+static size_t push_n(Ring r, const void* src, size_t count, ring_spans_t* spans) {
+  if (r == NULL) {
+    return 0;
+  }
+
+  if (src == NULL) {
+    _fail(r, RING_ERR__NULL_ELEM);
+    return 0;
+  }
+
+  size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+  size_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+  size_t free_slots = r->capacity - (tail - head);
+
+  if (count > free_slots) {
+    if (r->flags & RING_FLAG__OVERWRITE) {
+      //only the newest capacity elements can survive
+      if (count > r->capacity) {
+        src = (const char*)src + ((count - r->capacity) * r->elem_size);
+        count = r->capacity;
+      }
+
+      size_t dropped = count - free_slots;
+      _notify(r, RING_ACTION__OVERWRITE, head, dropped);
+      _destroy(r, head, dropped);
+      atomic_store_explicit(&r->head, head + dropped, memory_order_relaxed);
+    }
+    else {
+      count = free_slots;
+      if (count == 0) {
+        _fail(r, RING_ERR__FULL);
+      }
+    }
+  }
+
+  _copy_in(r, tail, src, count);
+  if (spans != NULL) {
+    _spans(r, tail, count, spans);
+  }
+
+  if (count > 0) {
+    _notify(r, RING_ACTION__PUSH, tail, count);
+  }
+  atomic_store_explicit(&r->tail, tail + count, memory_order_release);
+
+  return count;
+}
+
+static size_t pop_n(Ring r, void* dst, size_t count, ring_spans_t* spans) {
+  if (r == NULL) {
+    return 0;
+  }
+
+  //the producer may reuse popped slots right away, peek_n/consume is the zero copy read
+  if (spans != NULL && (r->flags & RING_FLAG__SPSC)) {
+    _fail(r, RING_ERR__MODE);
+    return 0;
+  }
+
+  size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+
+  if (count > tail - head) {
+    count = tail - head;
+    if (count == 0) {
+      _fail(r, RING_ERR__EMPTY);
+    }
+  }
+
+  if (count > 0) {
+    _notify(r, RING_ACTION__POP, head, count);
+  }
+
+  if (dst != NULL) {
+    _copy_out(r, head, dst, count);
+  }
+  else if (spans == NULL) {
+    _destroy(r, head, count);
+  }
+
+  if (spans != NULL) {
+    _spans(r, head, count, spans);
+  }
+  atomic_store_explicit(&r->head, head + count, memory_order_release);
+
+  return count;
+}
+
+static size_t peek_n(const Ring r, size_t count, ring_spans_t* spans) {
+  if (r == NULL || spans == NULL) {
+    return 0;
+  }
+
+  size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+
+  if (count > tail - head) {
+    count = tail - head;
+  }
+
+  _spans(r, head, count, spans);
+
+  return count;
+}
+
+static size_t consume(Ring r, size_t count) {
+  if (r == NULL) {
+    return 0;
+  }
+
+  size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+
+  if (count > tail - head) {
+    count = tail - head;
+  }
+
+  if (count > 0) {
+    _notify(r, RING_ACTION__POP, head, count);
+    _destroy(r, head, count);
+  }
+  atomic_store_explicit(&r->head, head + count, memory_order_release);
+
+  return count;
+}
+
+static void* at(const Ring r, size_t index) {
+  if (r == NULL) {
+    return NULL;
+  }
+
+  size_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+  size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+
+  if (index >= tail - head) {
+    return NULL;
+  }
+
+  return r->data + (((head + index) & r->mask) * r->elem_size);
+}
+
+//observers, in SPSC mode subscribe before the producer and consumer start
+static int32_t subscribe(Ring r, uint64_t action_mask, void (*cb)(uint32_t action_flag, const void* call_extra, void* cb_extra), void* cb_extra, int auto_free_extra) {
+  if (r == NULL) {
+    return RING_ERR__NULL_RING;
+  }
+
+  if (r->observer == NULL) {
+    r->observer = iObserver.construct();
+    if (r->observer == NULL) {
+      return _fail(r, RING_ERR__OBSERVER_CONSTRUCT);
+    }
+  }
+
+  return iObserver.subscribe(r->observer, action_mask, cb, cb_extra, auto_free_extra);
+}
+
+static void* unsubscribe(Ring r, uint64_t action_mask, void (*cb)(uint32_t action_flag, const void* call_extra, void* cb_extra)) {
+  if (r == NULL || r->observer == NULL) {
+    return NULL;
+  }
+
+  return iObserver.unsubscribe(r->observer, action_mask, cb);
+}
+
+RingBufferInterface iRing = {
+  .construct = construct,
+  .construct_with_allocator = construct_with_allocator,
+  .destruct = destruct,
+  .size = size,
+  .capacity = capacity,
+  .elem_size = elem_size,
+  .get_flags = get_flags,
+  .error = error,
+  .set_elem_destructor = set_elem_destructor,
+  .push_back = push_back,
+  .push_front = push_front,
+  .pop_front = pop_front,
+  .pop_back = pop_back,
+  .clear = clear,
+  .push_n = push_n,
+  .pop_n = pop_n,
+  .peek_n = peek_n,
+  .consume = consume,
+  .at = at,
+  .subscribe = subscribe,
+  .unsubscribe = unsubscribe
+};
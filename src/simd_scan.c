@@ -0,0 +1,399 @@
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#include "simd_scan_i.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_SCAN_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SIMD_TARGET(isa)
+#else
+#define SIMD_TARGET(isa)		__attribute__((target(isa)))
+#endif
+
+typedef struct {
+  size_t  (*find)(const char* data, size_t count, size_t width, const char* value, size_t start);
+  size_t  (*count_equal)(const char* data, size_t count, size_t width, const char* value);
+  size_t  (*find_all)(const char* data, size_t count, size_t width, const char* value, size_t* out);
+} scan_kernels_t;
+
+static once_flag detect_once = ONCE_FLAG_INIT;
+static uint32_t supported_isa = SIMD_ISA__SCALAR;
+static uint32_t active_isa = SIMD_ISA__SCALAR;
+
+static inline uint32_t _ctz32(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return (uint32_t)index;
+#else
+  return (uint32_t)__builtin_ctz(mask);
+#endif
+}
+
+static inline uint32_t _popcount32(uint32_t mask) {
+  mask = mask - ((mask >> 1) & 0x55555555u);
+  mask = (mask & 0x33333333u) + ((mask >> 2) & 0x33333333u);
+  return (((mask + (mask >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+}
+
+static inline int _equal(const char* a, const char* b, size_t width) {
+  uint16_t a16, b16;
+  uint32_t a32, b32;
+  uint64_t a64, b64;
+
+  switch (width) {
+    case 1:
+      return *a == *b;
+    case 2:
+      memcpy(&a16, a, 2);
+      memcpy(&b16, b, 2);
+      return a16 == b16;
+    case 4:
+      memcpy(&a32, a, 4);
+      memcpy(&b32, b, 4);
+      return a32 == b32;
+    default:
+      memcpy(&a64, a, 8);
+      memcpy(&b64, b, 8);
+      return a64 == b64;
+  }
+}
+
+//scalar
+static size_t _scalar_find(const char* data, size_t count, size_t width, const char* value, size_t start) {
+  for (size_t i = start; i < count; i++) {
+    if (_equal(data + (i * width), value, width)) {
+      return i;
+    }
+  }
+  return count;
+}
+
+static size_t _scalar_count(const char* data, size_t count, size_t width, const char* value) {
+  size_t matches = 0;
+  for (size_t i = 0; i < count; i++) {
+    matches += _equal(data + (i * width), value, width);
+  }
+  return matches;
+}
+
+static size_t _scalar_find_all(const char* data, size_t count, size_t width, const char* value, size_t* out) {
+  size_t matches = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (_equal(data + (i * width), value, width)) {
+      out[matches++] = i;
+    }
+  }
+  return matches;
+}
+
+static const scan_kernels_t scalar_kernels = { _scalar_find, _scalar_count, _scalar_find_all };
+
+#if defined(SIMD_SCAN_X86)
+
+//every match sets `width` consecutive bits of the byte mask
+static inline uint32_t _clear_lowest_match(uint32_t mask, size_t width) {
+  return mask & ~((((uint32_t)1 << width) - 1) << _ctz32(mask));
+}
+
+//sse2
+SIMD_TARGET("sse2")
+static inline __m128i _sse2_needle(const char* value, size_t width) {
+  char pattern[16];
+  for (size_t i = 0; i < 16; i += width) {
+    memcpy(pattern + i, value, width);
+  }
+  return _mm_loadu_si128((const __m128i*)pattern);
+}
+
+SIMD_TARGET("sse2")
+static inline uint32_t _sse2_mask(const char* ptr, __m128i needle, size_t width) {
+  __m128i block = _mm_loadu_si128((const __m128i*)ptr);
+  __m128i eq;
+
+  switch (width) {
+    case 1:
+      eq = _mm_cmpeq_epi8(block, needle);
+      break;
+    case 2:
+      eq = _mm_cmpeq_epi16(block, needle);
+      break;
+    case 4:
+      eq = _mm_cmpeq_epi32(block, needle);
+      break;
+    default:
+      //no 64 bit compare in sse2: both 32 bit halves have to match
+      eq = _mm_cmpeq_epi32(block, needle);
+      eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+      break;
+  }
+
+  return (uint32_t)_mm_movemask_epi8(eq);
+}
+
+SIMD_TARGET("sse2")
+static size_t _sse2_find(const char* data, size_t count, size_t width, const char* value, size_t start) {
+  __m128i needle = _sse2_needle(value, width);
+  size_t bytes = count * width;
+  size_t pos = start * width;
+
+  for (; pos + 16 <= bytes; pos += 16) {
+    uint32_t mask = _sse2_mask(data + pos, needle, width);
+    if (mask != 0) {
+      return (pos + _ctz32(mask)) / width;
+    }
+  }
+
+  return _scalar_find(data, count, width, value, pos / width);
+}
+
+SIMD_TARGET("sse2")
+static size_t _sse2_count(const char* data, size_t count, size_t width, const char* value) {
+  __m128i needle = _sse2_needle(value, width);
+  size_t bytes = count * width;
+  size_t pos = 0;
+  size_t matched_bits = 0;
+
+  for (; pos + 16 <= bytes; pos += 16) {
+    matched_bits += _popcount32(_sse2_mask(data + pos, needle, width));
+  }
+
+  return (matched_bits / width) + _scalar_count(data + pos, count - (pos / width), width, value);
+}
+
+SIMD_TARGET("sse2")
+static size_t _sse2_find_all(const char* data, size_t count, size_t width, const char* value, size_t* out) {
+  __m128i needle = _sse2_needle(value, width);
+  size_t bytes = count * width;
+  size_t pos = 0;
+  size_t matches = 0;
+
+  for (; pos + 16 <= bytes; pos += 16) {
+    uint32_t mask = _sse2_mask(data + pos, needle, width);
+    while (mask != 0) {
+      out[matches++] = (pos + _ctz32(mask)) / width;
+      mask = _clear_lowest_match(mask, width);
+    }
+  }
+
+  for (size_t i = pos / width; i < count; i++) {
+    if (_equal(data + (i * width), value, width)) {
+      out[matches++] = i;
+    }
+  }
+
+  return matches;
+}
+
+static const scan_kernels_t sse2_kernels = { _sse2_find, _sse2_count, _sse2_find_all };
+
+//avx2
+SIMD_TARGET("avx2")
+static inline __m256i _avx2_needle(const char* value, size_t width) {
+  char pattern[32];
+  for (size_t i = 0; i < 32; i += width) {
+    memcpy(pattern + i, value, width);
+  }
+  return _mm256_loadu_si256((const __m256i*)pattern);
+}
+
+SIMD_TARGET("avx2")
+static inline uint32_t _avx2_mask(const char* ptr, __m256i needle, size_t width) {
+  __m256i block = _mm256_loadu_si256((const __m256i*)ptr);
+  __m256i eq;
+
+  switch (width) {
+    case 1:
+      eq = _mm256_cmpeq_epi8(block, needle);
+      break;
+    case 2:
+      eq = _mm256_cmpeq_epi16(block, needle);
+      break;
+    case 4:
+      eq = _mm256_cmpeq_epi32(block, needle);
+      break;
+    default:
+      eq = _mm256_cmpeq_epi64(block, needle);
+      break;
+  }
+
+  return (uint32_t)_mm256_movemask_epi8(eq);
+}
+
+SIMD_TARGET("avx2")
+static size_t _avx2_find(const char* data, size_t count, size_t width, const char* value, size_t start) {
+  __m256i needle = _avx2_needle(value, width);
+  size_t bytes = count * width;
+  size_t pos = start * width;
+
+  for (; pos + 32 <= bytes; pos += 32) {
+    uint32_t mask = _avx2_mask(data + pos, needle, width);
+    if (mask != 0) {
+      return (pos + _ctz32(mask)) / width;
+    }
+  }
+
+  return _scalar_find(data, count, width, value, pos / width);
+}
+
+SIMD_TARGET("avx2")
+static size_t _avx2_count(const char* data, size_t count, size_t width, const char* value) {
+  __m256i needle = _avx2_needle(value, width);
+  size_t bytes = count * width;
+  size_t pos = 0;
+  size_t matched_bits = 0;
+
+  for (; pos + 32 <= bytes; pos += 32) {
+    matched_bits += _popcount32(_avx2_mask(data + pos, needle, width));
+  }
+
+  return (matched_bits / width) + _scalar_count(data + pos, count - (pos / width), width, value);
+}
+
+SIMD_TARGET("avx2")
+static size_t _avx2_find_all(const char* data, size_t count, size_t width, const char* value, size_t* out) {
+  __m256i needle = _avx2_needle(value, width);
+  size_t bytes = count * width;
+  size_t pos = 0;
+  size_t matches = 0;
+
+  for (; pos + 32 <= bytes; pos += 32) {
+    uint32_t mask = _avx2_mask(data + pos, needle, width);
+    while (mask != 0) {
+      out[matches++] = (pos + _ctz32(mask)) / width;
+      mask = _clear_lowest_match(mask, width);
+    }
+  }
+
+  for (size_t i = pos / width; i < count; i++) {
+    if (_equal(data + (i * width), value, width)) {
+      out[matches++] = i;
+    }
+  }
+
+  return matches;
+}
+
+static const scan_kernels_t avx2_kernels = { _avx2_find, _avx2_count, _avx2_find_all };
+
+static int _cpu_has_sse2(void) {
+#if defined(__x86_64__) || defined(_M_X64)
+  return 1;
+#elif defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  return (info[3] >> 26) & 1;
+#else
+  return __builtin_cpu_supports("sse2");
+#endif
+}
+
+static int _cpu_has_avx2(void) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) {
+    return 0;
+  }
+
+  //avx needs os support for ymm state
+  __cpuid(info, 1);
+  int osxsave = (info[2] >> 27) & 1;
+  int avx = (info[2] >> 28) & 1;
+  if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+    return 0;
+  }
+
+  __cpuidex(info, 7, 0);
+  return (info[1] >> 5) & 1;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+static void _detect(void) {
+#if defined(SIMD_SCAN_X86)
+  if (_cpu_has_avx2()) {
+    supported_isa = SIMD_ISA__AVX2;
+  }
+  else if (_cpu_has_sse2()) {
+    supported_isa = SIMD_ISA__SSE2;
+  }
+#endif
+  active_isa = supported_isa;
+}
+
+static const scan_kernels_t* _kernels(void) {
+  call_once(&detect_once, _detect);
+
+#if defined(SIMD_SCAN_X86)
+  switch (active_isa) {
+    case SIMD_ISA__AVX2:
+      return &avx2_kernels;
+    case SIMD_ISA__SSE2:
+      return &sse2_kernels;
+    default:
+      break;
+  }
+#endif
+
+  return &scalar_kernels;
+}
+
+static int _valid_width(size_t width) {
+  return width == 1 || width == 2 || width == 4 || width == 8;
+}
+
+static size_t find(const void* data, size_t count, size_t width, const void* value, size_t start) {
+  if (data == NULL || value == NULL || !_valid_width(width) || start >= count) {
+    return count;
+  }
+
+  return _kernels()->find(data, count, width, value, start);
+}
+
+static size_t count_equal(const void* data, size_t count, size_t width, const void* value) {
+  if (data == NULL || value == NULL || !_valid_width(width)) {
+    return 0;
+  }
+
+  return _kernels()->count_equal(data, count, width, value);
+}
+
+static size_t find_all(const void* data, size_t count, size_t width, const void* value, size_t* out) {
+  if (data == NULL || value == NULL || out == NULL || !_valid_width(width)) {
+    return 0;
+  }
+
+  return _kernels()->find_all(data, count, width, value, out);
+}
+
+static uint32_t isa(void) {
+  call_once(&detect_once, _detect);
+  return active_isa;
+}
+
+static uint32_t set_isa(uint32_t requested) {
+  call_once(&detect_once, _detect);
+  active_isa = requested < supported_isa ? requested : supported_isa;
+  return active_isa;
+}
+
+SimdScanInterface_t iSimdScan = {
+  .find = find,
+  .count_equal = count_equal,
+  .find_all = find_all,
+  .isa = isa,
+  .set_isa = set_isa
+};
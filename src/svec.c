@@ -0,0 +1,588 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocator_i.h"
+#include "psort_i.h"
+#include "svec_i.h"
+
+typedef struct {
+  size_t  size;
+  size_t  offset;
+  char*   data;
+} svec_field_t;
+
+//all columns share one block: column i starts at an align boundary and holds capacity values.
+//fields and row (scratch for for_each) are allocated together with the vector.
+struct tagSoAVector {
+  size_t                    field_count;
+  svec_field_t*             fields;
+  void**                    row;
+  size_t                    record_size;
+  size_t                    align;
+
+  size_t                    size;
+  size_t                    capacity;
+  char*                     block;
+
+  size_t                    sort_field;
+  int32_t                   (*cmp_fn)(const void* first, const void* second);
+
+  const AllocatorInterface* allocator;
+  uint32_t                  error;
+};
+
+static inline size_t _align_up(size_t value, size_t align) {
+  return (value + align - 1) & ~(align - 1);
+}
+
+static inline char* _value(const SVec v, size_t field, size_t index) {
+  return v->fields[field].data + (index * v->fields[field].size);
+}
+
+static int32_t _check_field(const SVec v, size_t field) {
+  if (field >= v->field_count) {
+    v->error = VEC_ERR__INVALID_INDEX;
+    return VEC_ERR__INVALID_INDEX;
+  }
+
+  return VEC_OK;
+}
+
+//moves the columns into a new block of capacity values each
+static int32_t _realloc(SVec v, size_t capacity) {
+  size_t bytes = v->align - 1;
+  for (size_t f = 0; f < v->field_count; f++) {
+    bytes += _align_up(capacity * v->fields[f].size, v->align);
+  }
+
+  char* block = v->allocator->malloc(bytes);
+  if (block == NULL) {
+    v->error = VEC_ERR__MALLOC;
+    return VEC_ERR__MALLOC;
+  }
+
+  char* column = (char*)_align_up((uintptr_t)block, v->align);
+  for (size_t f = 0; f < v->field_count; f++) {
+    if (v->size > 0) {
+      memcpy(column, v->fields[f].data, v->size * v->fields[f].size);
+    }
+    v->fields[f].data = column;
+    column += _align_up(capacity * v->fields[f].size, v->align);
+  }
+
+  v->allocator->free(v->block);
+  v->block = block;
+  v->capacity = capacity;
+
+  return VEC_OK;
+}
+
+static int32_t _grow(SVec v, size_t needed) {
+  if (needed <= v->capacity) {
+    return VEC_OK;
+  }
+
+  size_t capacity = v->capacity < VEC_MIN_SIZE ? VEC_MIN_SIZE : v->capacity * VEC_REALLOC_SCALE_FACTOR;
+  if (capacity < needed) {
+    capacity = needed;
+  }
+
+  return _realloc(v, capacity);
+}
+
+static void _scatter(SVec v, size_t index, const char* record) {
+  for (size_t f = 0; f < v->field_count; f++) {
+    memcpy(_value(v, f, index), record + v->fields[f].offset, v->fields[f].size);
+  }
+}
+
+//moves values [index, size) of every column by count positions
+static void _shift(SVec v, size_t index, size_t count, int up) {
+  size_t moved = v->size - index - (up ? 0 : count);
+  if (moved == 0) {
+    return;
+  }
+
+  for (size_t f = 0; f < v->field_count; f++) {
+    char* at = _value(v, f, index);
+    char* far = _value(v, f, index + count);
+    memmove(up ? far : at, up ? at : far, moved * v->fields[f].size);
+  }
+}
+
+//live cycle
+static SVec construct_with_schema(const svec_schema_t* schema, const AllocatorInterface* allocator) {
+  if (schema == NULL || schema->sizes == NULL || schema->count == 0) {
+    return NULL;
+  }
+
+  size_t align = schema->align == 0 ? SVEC_COLUMN_ALIGN : schema->align;
+  if ((align & (align - 1)) != 0) {
+    return NULL;
+  }
+
+  if (allocator == NULL) {
+    allocator = CurrentAllocator;
+  }
+
+  size_t count = schema->count;
+  SVec v = allocator->malloc(sizeof(struct tagSoAVector) + (count * (sizeof(svec_field_t) + sizeof(void*))));
+  if (v == NULL) {
+    return NULL;
+  }
+
+  v->field_count = count;
+  v->fields = (svec_field_t*)(v + 1);
+  v->row = (void**)(v->fields + count);
+
+  size_t end = 0;
+  for (size_t f = 0; f < count; f++) {
+    if (schema->sizes[f] == 0) {
+      allocator->free(v);
+      return NULL;
+    }
+
+    v->fields[f].size = schema->sizes[f];
+    v->fields[f].offset = schema->offsets != NULL ? schema->offsets[f] : end;
+    v->fields[f].data = NULL;
+
+    if (v->fields[f].offset + v->fields[f].size > end) {
+      end = v->fields[f].offset + v->fields[f].size;
+    }
+  }
+
+  if (schema->record_size != 0 && schema->record_size < end) {
+    allocator->free(v);
+    return NULL;
+  }
+
+  v->record_size = schema->record_size != 0 ? schema->record_size : end;
+  v->align = align;
+  v->size = 0;
+  v->capacity = 0;
+  v->block = NULL;
+  v->sort_field = 0;
+  v->cmp_fn = NULL;
+  v->allocator = allocator;
+  v->error = VEC_OK;
+
+  return v;
+}
+
+static SVec construct(const size_t* field_sizes, size_t field_count) {
+  svec_schema_t schema = { field_sizes, NULL, field_count, 0, 0 };
+  return construct_with_schema(&schema, NULL);
+}
+
+static int32_t destruct(SVec v) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  v->allocator->free(v->block);
+  v->allocator->free(v);
+
+  return VEC_OK;
+}
+
+//info
+static size_t size(const SVec v) {
+  return v != NULL ? v->size : 0;
+}
+
+static size_t capacity(const SVec v) {
+  return v != NULL ? v->capacity : 0;
+}
+
+static size_t field_count(const SVec v) {
+  return v != NULL ? v->field_count : 0;
+}
+
+static size_t field_size(const SVec v, size_t field) {
+  return v != NULL && field < v->field_count ? v->fields[field].size : 0;
+}
+
+static size_t record_size(const SVec v) {
+  return v != NULL ? v->record_size : 0;
+}
+
+static uint32_t error(const SVec v) {
+  return v != NULL ? v->error : (uint32_t)VEC_ERR__NULL_VEC;
+}
+
+static int32_t set_compare_fn(SVec v, size_t field, int32_t (*cmp)(const void* first, const void* second)) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (cmp == NULL) {
+    v->error = VEC_ERR__NULL_CMP_FN;
+    return VEC_ERR__NULL_CMP_FN;
+  }
+
+  int32_t res = _check_field(v, field);
+  if (res < 0) {
+    return res;
+  }
+
+  v->sort_field = field;
+  v->cmp_fn = cmp;
+
+  return VEC_OK;
+}
+
+//memory
+static int32_t reserve(SVec v, size_t capacity) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  return capacity > v->capacity ? _realloc(v, capacity) : VEC_OK;
+}
+
+static int32_t shrink_to_fit(SVec v) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (v->size == v->capacity) {
+    return VEC_OK;
+  }
+
+  if (v->size == 0) {
+    v->allocator->free(v->block);
+    v->block = NULL;
+    v->capacity = 0;
+    for (size_t f = 0; f < v->field_count; f++) {
+      v->fields[f].data = NULL;
+    }
+    return VEC_OK;
+  }
+
+  return _realloc(v, v->size);
+}
+
+//add
+static int32_t add_range(SVec v, const void* records, size_t count) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (records == NULL) {
+    v->error = VEC_ERR__NULL_ELEM;
+    return VEC_ERR__NULL_ELEM;
+  }
+
+  if (count == 0) {
+    return VEC_OK;
+  }
+
+  int32_t res = _grow(v, v->size + count);
+  if (res < 0) {
+    return res;
+  }
+
+  //column by column: each destination is written sequentially
+  const char* src = records;
+  for (size_t f = 0; f < v->field_count; f++) {
+    size_t field_size = v->fields[f].size;
+    const char* from = src + v->fields[f].offset;
+    char* to = _value(v, f, v->size);
+
+    for (size_t i = 0; i < count; i++) {
+      memcpy(to, from, field_size);
+      to += field_size;
+      from += v->record_size;
+    }
+  }
+
+  v->size += count;
+
+  return VEC_OK;
+}
+
+static int32_t add(SVec v, const void* record) {
+  return add_range(v, record, 1);
+}
+
+static int32_t insert_at(SVec v, size_t index, const void* record) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (record == NULL) {
+    v->error = VEC_ERR__NULL_ELEM;
+    return VEC_ERR__NULL_ELEM;
+  }
+
+  if (index > v->size) {
+    v->error = VEC_ERR__INVALID_INDEX;
+    return VEC_ERR__INVALID_INDEX;
+  }
+
+  int32_t res = _grow(v, v->size + 1);
+  if (res < 0) {
+    return res;
+  }
+
+  _shift(v, index, 1, 1);
+  _scatter(v, index, record);
+  v->size++;
+
+  return VEC_OK;
+}
+
+static int32_t replace_at(SVec v, size_t index, const void* record) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (record == NULL) {
+    v->error = VEC_ERR__NULL_ELEM;
+    return VEC_ERR__NULL_ELEM;
+  }
+
+  if (index >= v->size) {
+    v->error = VEC_ERR__INVALID_INDEX;
+    return VEC_ERR__INVALID_INDEX;
+  }
+
+  _scatter(v, index, record);
+
+  return VEC_OK;
+}
+
+//remove
+static int32_t clear(SVec v) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  v->size = 0;
+
+  return VEC_OK;
+}
+
+static int32_t erase_range(SVec v, size_t begin_index, size_t end_index) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (begin_index > end_index || end_index > v->size) {
+    v->error = VEC_ERR__INVALID_INDEX;
+    return VEC_ERR__INVALID_INDEX;
+  }
+
+  _shift(v, begin_index, end_index - begin_index, 0);
+  v->size -= end_index - begin_index;
+
+  return VEC_OK;
+}
+
+static int32_t erase_at(SVec v, size_t index) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (index >= v->size) {
+    v->error = VEC_ERR__INVALID_INDEX;
+    return VEC_ERR__INVALID_INDEX;
+  }
+
+  return erase_range(v, index, index + 1);
+}
+
+//access
+static int32_t at(const SVec v, size_t index, void* out) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (out == NULL) {
+    v->error = VEC_ERR__NULL_ELEM;
+    return VEC_ERR__NULL_ELEM;
+  }
+
+  if (index >= v->size) {
+    v->error = VEC_ERR__INVALID_INDEX;
+    return VEC_ERR__INVALID_INDEX;
+  }
+
+  for (size_t f = 0; f < v->field_count; f++) {
+    memcpy((char*)out + v->fields[f].offset, _value(v, f, index), v->fields[f].size);
+  }
+
+  return VEC_OK;
+}
+
+static void* field_at(const SVec v, size_t field, size_t index) {
+  if (v == NULL || _check_field(v, field) < 0) {
+    return NULL;
+  }
+
+  if (index >= v->size) {
+    v->error = VEC_ERR__INVALID_INDEX;
+    return NULL;
+  }
+
+  return _value(v, field, index);
+}
+
+static int32_t for_each(SVec v, void (*cb)(void* const* fields, size_t index, void* extra), void* extra) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (cb == NULL) {
+    v->error = VEC_ERR__NULL_CALLBACK;
+    return VEC_ERR__NULL_CALLBACK;
+  }
+
+  if (v->size == 0) {
+    v->error = VEC_ERR__EMPTY_VEC;
+    return VEC_ERR__EMPTY_VEC;
+  }
+
+  for (size_t f = 0; f < v->field_count; f++) {
+    v->row[f] = v->fields[f].data;
+  }
+
+  for (size_t i = 0; i < v->size; i++) {
+    cb(v->row, i, extra);
+
+    for (size_t f = 0; f < v->field_count; f++) {
+      v->row[f] = (char*)v->row[f] + v->fields[f].size;
+    }
+  }
+
+  return VEC_OK;
+}
+
+//columns
+static int32_t column_range(const SVec v, size_t field, size_t begin_index, size_t end_index, svec_span_t* out) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (out == NULL) {
+    v->error = VEC_ERR__NULL_ELEM;
+    return VEC_ERR__NULL_ELEM;
+  }
+
+  int32_t res = _check_field(v, field);
+  if (res < 0) {
+    return res;
+  }
+
+  if (begin_index > end_index || end_index > v->size) {
+    v->error = VEC_ERR__INVALID_INDEX;
+    return VEC_ERR__INVALID_INDEX;
+  }
+
+  out->data = v->fields[field].data != NULL ? _value(v, field, begin_index) : NULL;
+  out->count = end_index - begin_index;
+  out->elem_size = v->fields[field].size;
+
+  return VEC_OK;
+}
+
+static int32_t column(const SVec v, size_t field, svec_span_t* out) {
+  return column_range(v, field, 0, v != NULL ? v->size : 0, out);
+}
+
+//sort
+static int32_t sort(SVec v) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (v->cmp_fn == NULL) {
+    v->error = VEC_ERR__NULL_CMP_FN;
+    return VEC_ERR__NULL_CMP_FN;
+  }
+
+  if (v->size < 2) {
+    return VEC_OK;
+  }
+
+  //entries are the key followed by its index, cmp sees the key at the start of an entry
+  size_t key_size = v->fields[v->sort_field].size;
+  size_t index_offset = _align_up(key_size, sizeof(size_t));
+  size_t entry_size = index_offset + sizeof(size_t);
+
+  size_t scratch_size = 0;
+  for (size_t f = 0; f < v->field_count; f++) {
+    if (v->fields[f].size > scratch_size) {
+      scratch_size = v->fields[f].size;
+    }
+  }
+
+  char* entries = v->allocator->malloc(v->size * entry_size);
+  char* scratch = v->allocator->malloc(v->size * scratch_size);
+  if (entries == NULL || scratch == NULL) {
+    v->allocator->free(entries);
+    v->allocator->free(scratch);
+    v->error = VEC_ERR__MALLOC;
+    return VEC_ERR__MALLOC;
+  }
+
+  for (size_t i = 0; i < v->size; i++) {
+    char* entry = entries + (i * entry_size);
+    memcpy(entry, _value(v, v->sort_field, i), key_size);
+    memcpy(entry + index_offset, &i, sizeof(size_t));
+  }
+
+  psort_config_t config = { 0, 0, 1 };
+  if (iPSort.sort(entries, v->size, entry_size, v->cmp_fn, &config) < 0) {
+    v->allocator->free(entries);
+    v->allocator->free(scratch);
+    v->error = VEC_ERR__MALLOC;
+    return VEC_ERR__MALLOC;
+  }
+
+  //gather every column through the permutation
+  for (size_t f = 0; f < v->field_count; f++) {
+    size_t field_size = v->fields[f].size;
+
+    for (size_t i = 0; i < v->size; i++) {
+      size_t from;
+      memcpy(&from, entries + (i * entry_size) + index_offset, sizeof(size_t));
+      memcpy(scratch + (i * field_size), _value(v, f, from), field_size);
+    }
+
+    memcpy(v->fields[f].data, scratch, v->size * field_size);
+  }
+
+  v->allocator->free(entries);
+  v->allocator->free(scratch);
+
+  return VEC_OK;
+}
+
+SoAVectorInterface iSVec = {
+  .construct = construct,
+  .construct_with_schema = construct_with_schema,
+  .destruct = destruct,
+  .size = size,
+  .capacity = capacity,
+  .field_count = field_count,
+  .field_size = field_size,
+  .record_size = record_size,
+  .error = error,
+  .set_compare_fn = set_compare_fn,
+  .reserve = reserve,
+  .shrink_to_fit = shrink_to_fit,
+  .add = add,
+  .add_range = add_range,
+  .insert_at = insert_at,
+  .replace_at = replace_at,
+  .clear = clear,
+  .erase_at = erase_at,
+  .erase_range = erase_range,
+  .at = at,
+  .field_at = field_at,
+  .for_each = for_each,
+  .column = column,
+  .column_range = column_range,
+  .sort = sort
+};
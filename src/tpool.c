@@ -0,0 +1,464 @@
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "allocator_i.h"
+#include "tpool_i.h"
+
+typedef struct {
+  void  (*fn)(void* arg);
+  void* arg;
+} tpool_task_t;
+
+//owner pushes and pops at the tail, thieves take from the head
+typedef struct {
+  mtx_t         lock;
+  tpool_task_t* tasks;
+  size_t        head;
+  size_t        tail;
+  size_t        capacity;
+} tpool_deque_t;
+
+typedef struct {
+  ThreadPool  pool;
+  size_t      index;
+} tpool_worker_t;
+
+struct ThreadPool_t {
+  size_t                    thread_count;
+  thrd_t                    threads[TPOOL_MAX_THREADS];
+  tpool_worker_t            workers[TPOOL_MAX_THREADS];
+  tpool_deque_t             deques[TPOOL_MAX_THREADS];
+  const AllocatorInterface* allocator;
+
+  atomic_size_t             next_deque;
+  atomic_size_t             pending;      //queued
+  atomic_size_t             unfinished;   //queued + running
+  atomic_int                stop;
+
+  mtx_t                     lock;
+  cnd_t                     work_cnd;
+  cnd_t                     idle_cnd;
+};
+
+//tasks of one parallel_for call
+typedef struct {
+  atomic_size_t remaining;
+  ThreadPool    pool;
+} tpool_group_t;
+
+typedef struct {
+  tpool_group_t*  group;
+  size_t          begin;
+  size_t          end;
+  void            (*body)(size_t begin, size_t end, void* arg);
+  void*           arg;
+} tpool_chunk_t;
+
+static ALLOCATOR_THREAD_LOCAL tpool_worker_t* current_worker = NULL;
+
+static once_flag default_once = ONCE_FLAG_INIT;
+static ThreadPool default_instance = NULL;
+
+static int32_t _deque_push(ThreadPool pool, tpool_deque_t* deque, tpool_task_t task) {
+  mtx_lock(&deque->lock);
+
+  if (deque->tail - deque->head == deque->capacity) {
+    size_t new_capacity = deque->capacity * 2;
+    tpool_task_t* tasks = pool->allocator->malloc(new_capacity * sizeof(tpool_task_t));
+    if (tasks == NULL) {
+      mtx_unlock(&deque->lock);
+      return TPOOL_ERR__MALLOC;
+    }
+
+    for (size_t i = deque->head; i < deque->tail; i++) {
+      tasks[i & (new_capacity - 1)] = deque->tasks[i & (deque->capacity - 1)];
+    }
+
+    pool->allocator->free(deque->tasks);
+    deque->tasks = tasks;
+    deque->capacity = new_capacity;
+  }
+
+  deque->tasks[deque->tail & (deque->capacity - 1)] = task;
+  deque->tail++;
+
+  mtx_unlock(&deque->lock);
+  return TPOOL_OK;
+}
+
+static int _deque_pop(tpool_deque_t* deque, tpool_task_t* task) {
+  int found = 0;
+
+  mtx_lock(&deque->lock);
+  if (deque->tail != deque->head) {
+    deque->tail--;
+    *task = deque->tasks[deque->tail & (deque->capacity - 1)];
+    found = 1;
+  }
+  mtx_unlock(&deque->lock);
+
+  return found;
+}
+
+static int _deque_steal(tpool_deque_t* deque, tpool_task_t* task) {
+  int found = 0;
+
+  mtx_lock(&deque->lock);
+  if (deque->tail != deque->head) {
+    *task = deque->tasks[deque->head & (deque->capacity - 1)];
+    deque->head++;
+    found = 1;
+  }
+  mtx_unlock(&deque->lock);
+
+  return found;
+}
+
+//own deque first (newest task), then steal the oldest task of the others
+static int _take_task(ThreadPool pool, size_t index, tpool_task_t* task) {
+  if (atomic_load(&pool->pending) == 0) {
+    return 0;
+  }
+
+  if (index < pool->thread_count && _deque_pop(&pool->deques[index], task)) {
+    atomic_fetch_sub(&pool->pending, 1);
+    return 1;
+  }
+
+  for (size_t i = 1; i <= pool->thread_count; i++) {
+    size_t victim = (index + i) % pool->thread_count;
+    if (_deque_steal(&pool->deques[victim], task)) {
+      atomic_fetch_sub(&pool->pending, 1);
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static void _run_task(ThreadPool pool, tpool_task_t* task) {
+  task->fn(task->arg);
+
+  if (atomic_fetch_sub(&pool->unfinished, 1) == 1) {
+    mtx_lock(&pool->lock);
+    cnd_broadcast(&pool->idle_cnd);
+    mtx_unlock(&pool->lock);
+  }
+}
+
+static size_t _own_index(ThreadPool pool) {
+  if (current_worker != NULL && current_worker->pool == pool) {
+    return current_worker->index;
+  }
+  return pool->thread_count;
+}
+
+static int _worker(void* arg) {
+  tpool_worker_t* worker = arg;
+  ThreadPool pool = worker->pool;
+  tpool_task_t task;
+
+  current_worker = worker;
+
+  for (;;) {
+    if (_take_task(pool, worker->index, &task)) {
+      _run_task(pool, &task);
+      continue;
+    }
+
+    mtx_lock(&pool->lock);
+    while (atomic_load(&pool->pending) == 0 && !atomic_load(&pool->stop)) {
+      cnd_wait(&pool->work_cnd, &pool->lock);
+    }
+    int finished = atomic_load(&pool->stop) && atomic_load(&pool->pending) == 0;
+    mtx_unlock(&pool->lock);
+
+    if (finished) {
+      break;
+    }
+  }
+
+  current_worker = NULL;
+  return 0;
+}
+
+static size_t hardware_threads(void) {
+#if defined(_WIN32)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+#else
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (size_t)count : 1;
+#endif
+}
+
+static void destruct(ThreadPool pool);
+
+//live cycle
+static ThreadPool construct(size_t threads) {
+  if (threads == 0) {
+    threads = hardware_threads();
+  }
+
+  if (threads > TPOOL_MAX_THREADS) {
+    threads = TPOOL_MAX_THREADS;
+  }
+
+  ThreadPool pool = CurrentAllocator->malloc(sizeof(struct ThreadPool_t));
+  if (pool == NULL) {
+    return NULL;
+  }
+
+  pool->thread_count = 0;
+  pool->allocator = CurrentAllocator;
+  atomic_init(&pool->next_deque, 0);
+  atomic_init(&pool->pending, 0);
+  atomic_init(&pool->unfinished, 0);
+  atomic_init(&pool->stop, 0);
+
+  mtx_init(&pool->lock, mtx_plain);
+  cnd_init(&pool->work_cnd);
+  cnd_init(&pool->idle_cnd);
+
+  for (size_t i = 0; i < threads; i++) {
+    tpool_deque_t* deque = &pool->deques[i];
+    deque->tasks = pool->allocator->malloc(TPOOL_DEQUE_START_CAPACITY * sizeof(tpool_task_t));
+    if (deque->tasks == NULL) {
+      destruct(pool);
+      return NULL;
+    }
+
+    mtx_init(&deque->lock, mtx_plain);
+    deque->head = 0;
+    deque->tail = 0;
+    deque->capacity = TPOOL_DEQUE_START_CAPACITY;
+
+    pool->workers[i].pool = pool;
+    pool->workers[i].index = i;
+
+    if (thrd_create(&pool->threads[i], _worker, &pool->workers[i]) != thrd_success) {
+      pool->allocator->free(deque->tasks);
+      mtx_destroy(&deque->lock);
+      destruct(pool);
+      return NULL;
+    }
+
+    pool->thread_count++;
+  }
+
+  return pool;
+}
+
+//finishes queued tasks, then joins the workers
+static void destruct(ThreadPool pool) {
+  if (pool == NULL) {
+    return;
+  }
+
+  mtx_lock(&pool->lock);
+  atomic_store(&pool->stop, 1);
+  cnd_broadcast(&pool->work_cnd);
+  mtx_unlock(&pool->lock);
+
+  for (size_t i = 0; i < pool->thread_count; i++) {
+    thrd_join(pool->threads[i], NULL);
+  }
+
+  for (size_t i = 0; i < pool->thread_count; i++) {
+    pool->allocator->free(pool->deques[i].tasks);
+    mtx_destroy(&pool->deques[i].lock);
+  }
+
+  cnd_destroy(&pool->idle_cnd);
+  cnd_destroy(&pool->work_cnd);
+  mtx_destroy(&pool->lock);
+
+  pool->allocator->free(pool);
+}
+
+//workers must be joined before the process tears down the C runtime
+static void _destroy_default(void) {
+  ThreadPool pool = default_instance;
+  default_instance = NULL;
+  destruct(pool);
+}
+
+static void _create_default(void) {
+  default_instance = construct(0);
+  if (default_instance != NULL) {
+    atexit(_destroy_default);
+  }
+}
+
+static ThreadPool default_pool(void) {
+  call_once(&default_once, _create_default);
+  return default_instance;
+}
+
+static int32_t submit(ThreadPool pool, void (*fn)(void* arg), void* arg) {
+  if (pool == NULL) {
+    return TPOOL_ERR__NULL_POOL;
+  }
+
+  if (fn == NULL) {
+    return TPOOL_ERR__NULL_TASK;
+  }
+
+  if (atomic_load(&pool->stop)) {
+    return TPOOL_ERR__STOPPED;
+  }
+
+  //workers keep their own tasks local, outside callers spread them round robin
+  size_t index = _own_index(pool);
+  if (index == pool->thread_count) {
+    index = atomic_fetch_add(&pool->next_deque, 1) % pool->thread_count;
+  }
+
+  tpool_task_t task = { fn, arg };
+
+  //counted before it's visible: a thief may take it and decrement right after the push
+  atomic_fetch_add(&pool->unfinished, 1);
+  atomic_fetch_add(&pool->pending, 1);
+  if (_deque_push(pool, &pool->deques[index], task) < 0) {
+    atomic_fetch_sub(&pool->pending, 1);
+    atomic_fetch_sub(&pool->unfinished, 1);
+    return TPOOL_ERR__MALLOC;
+  }
+
+  mtx_lock(&pool->lock);
+  cnd_signal(&pool->work_cnd);
+  mtx_unlock(&pool->lock);
+
+  return TPOOL_OK;
+}
+
+//must not be called from a task of the same pool
+static void wait(ThreadPool pool) {
+  if (pool == NULL) {
+    return;
+  }
+
+  mtx_lock(&pool->lock);
+  while (atomic_load(&pool->unfinished) > 0) {
+    cnd_wait(&pool->idle_cnd, &pool->lock);
+  }
+  mtx_unlock(&pool->lock);
+}
+
+static void _chunk_task(void* arg) {
+  tpool_chunk_t* chunk = arg;
+  tpool_group_t* group = chunk->group;
+
+  ThreadPool pool = group->pool;
+
+  chunk->body(chunk->begin, chunk->end, chunk->arg);
+
+  //group and chunk live on the waiter's stack, the waiter may return right after the decrement
+  if (atomic_fetch_sub(&group->remaining, 1) == 1) {
+    mtx_lock(&pool->lock);
+    cnd_broadcast(&pool->idle_cnd);
+    mtx_unlock(&pool->lock);
+  }
+}
+
+static int32_t parallel_for(ThreadPool pool, size_t count, size_t grain, void (*body)(size_t begin, size_t end, void* arg), void* arg) {
+  if (pool == NULL) {
+    return TPOOL_ERR__NULL_POOL;
+  }
+
+  if (body == NULL) {
+    return TPOOL_ERR__NULL_TASK;
+  }
+
+  if (count == 0) {
+    return TPOOL_OK;
+  }
+
+  if (grain == 0) {
+    grain = 1;
+  }
+
+  size_t chunk_count = (count + grain - 1) / grain;
+  if (chunk_count == 1) {
+    body(0, count, arg);
+    return TPOOL_OK;
+  }
+
+  tpool_chunk_t* chunks = pool->allocator->malloc(chunk_count * sizeof(tpool_chunk_t));
+  if (chunks == NULL) {
+    return TPOOL_ERR__MALLOC;
+  }
+
+  tpool_group_t group;
+  group.pool = pool;
+  atomic_init(&group.remaining, chunk_count);
+
+  for (size_t i = 0; i < chunk_count; i++) {
+    chunks[i].group = &group;
+    chunks[i].begin = i * grain;
+    chunks[i].end = (i + 1) * grain < count ? (i + 1) * grain : count;
+    chunks[i].body = body;
+    chunks[i].arg = arg;
+  }
+
+  //first chunk stays on this thread, a chunk that can't be queued runs inline
+  for (size_t i = 1; i < chunk_count; i++) {
+    if (submit(pool, _chunk_task, &chunks[i]) < 0) {
+      _chunk_task(&chunks[i]);
+    }
+  }
+  _chunk_task(&chunks[0]);
+
+  //help with queued work instead of sleeping, this keeps nested calls from a worker alive
+  size_t index = _own_index(pool);
+  tpool_task_t task;
+
+  while (atomic_load(&group.remaining) > 0) {
+    if (_take_task(pool, index, &task)) {
+      _run_task(pool, &task);
+      continue;
+    }
+
+    mtx_lock(&pool->lock);
+    if (atomic_load(&group.remaining) > 0) {
+      struct timespec until;
+      timespec_get(&until, TIME_UTC);
+      until.tv_nsec += 1000000;
+      if (until.tv_nsec >= 1000000000) {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000;
+      }
+      cnd_timedwait(&pool->idle_cnd, &pool->lock, &until);
+    }
+    mtx_unlock(&pool->lock);
+  }
+
+  pool->allocator->free(chunks);
+
+  return TPOOL_OK;
+}
+
+static size_t threads(const ThreadPool pool) {
+  return pool == NULL ? 0 : pool->thread_count;
+}
+
+ThreadPoolInterface_t iThreadPool = {
+  .construct = construct,
+  .destruct = destruct,
+  .default_pool = default_pool,
+  .submit = submit,
+  .wait = wait,
+  .parallel_for = parallel_for,
+  .threads = threads,
+  .hardware_threads = hardware_threads
+};
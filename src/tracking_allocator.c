@@ -0,0 +1,336 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "allocator_i.h"
+#include "tracking_allocator_i.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#pragma intrinsic(_ReturnAddress)
+#define TRACKER_CALLER()		_ReturnAddress()
+#else
+#define TRACKER_CALLER()		__builtin_return_address(0)
+#endif
+
+#define TRACKER_ALIGNMENT		16
+#define TRACKER_ALIGN_UP(n)	(((n) + (TRACKER_ALIGNMENT - 1)) & ~((size_t)TRACKER_ALIGNMENT - 1))
+
+struct Tracker_t {
+  const AllocatorInterface* inner;
+  tracker_stats_t           stats;
+  tracker_call_site_t       sites[TRACKER_MAX_CALL_SITES];
+  tracker_call_site_t       overflow_site;
+  //blocks not freed yet, a destructed tracker lives until the last one is freed
+  size_t                    live_blocks;
+  int                       destructed;
+};
+
+//every block remembers its tracker and size, so free knows what to subtract
+typedef struct {
+  Tracker tracker;
+  size_t  size;
+} tracker_block_t;
+
+#define TRACKER_HEADER_SIZE		TRACKER_ALIGN_UP(sizeof(tracker_block_t))
+
+static ALLOCATOR_THREAD_LOCAL Tracker bound_tracker = NULL;
+
+static size_t _histogram_bucket(size_t size) {
+  size_t bucket = 0;
+  while (size > 1 && bucket < TRACKER_HISTOGRAM_BUCKETS - 1) {
+    size >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+static tracker_call_site_t* _call_site(Tracker tracker, const void* address) {
+  size_t start = ((uintptr_t)address >> 4) % TRACKER_MAX_CALL_SITES;
+
+  for (size_t i = 0; i < TRACKER_MAX_CALL_SITES; i++) {
+    tracker_call_site_t* site = &tracker->sites[(start + i) % TRACKER_MAX_CALL_SITES];
+
+    if (site->address == address) {
+      return site;
+    }
+
+    if (site->address == NULL) {
+      site->address = address;
+      return site;
+    }
+  }
+
+  return &tracker->overflow_site;
+}
+
+static void _record_request(Tracker tracker, const void* caller, size_t size, int is_realloc) {
+  tracker_call_site_t* site = _call_site(tracker, caller);
+
+  site->calls++;
+  site->bytes += size;
+  if (is_realloc) {
+    site->realloc_calls++;
+  }
+
+  tracker->stats.total_bytes += size;
+  tracker->stats.size_histogram[_histogram_bucket(size)]++;
+}
+
+static void _add_live(Tracker tracker, size_t size) {
+  tracker->stats.live_bytes += size;
+  if (tracker->stats.live_bytes > tracker->stats.peak_bytes) {
+    tracker->stats.peak_bytes = tracker->stats.live_bytes;
+  }
+}
+
+static void* _tracked_malloc(Tracker tracker, size_t size) {
+  tracker_block_t* block = tracker->inner->malloc(TRACKER_HEADER_SIZE + size);
+  if (block == NULL) {
+    tracker->stats.failed_calls++;
+    return NULL;
+  }
+
+  block->tracker = tracker;
+  block->size = size;
+  tracker->live_blocks++;
+  _add_live(tracker, size);
+
+  return (char*)block + TRACKER_HEADER_SIZE;
+}
+
+//live cycle
+static Tracker construct(const AllocatorInterface* inner) {
+  if (inner == NULL) {
+    inner = CurrentAllocator;
+  }
+
+  //wrapping ourselves would recurse forever
+  if (inner == &TrackingAllocator) {
+    inner = &DefaultAllocator;
+  }
+
+  Tracker tracker = DefaultAllocator.calloc(1, sizeof(struct Tracker_t));
+  if (tracker == NULL) {
+    return NULL;
+  }
+
+  tracker->inner = inner;
+
+  return tracker;
+}
+
+static void destruct(Tracker tracker) {
+  if (tracker == NULL) {
+    return;
+  }
+
+  if (bound_tracker == tracker) {
+    bound_tracker = NULL;
+  }
+
+  //blocks still point to it, the last tracking_free releases it
+  if (tracker->live_blocks > 0) {
+    tracker->destructed = 1;
+    return;
+  }
+
+  DefaultAllocator.free(tracker);
+}
+
+//binding
+static AllocatorInterface* bind(Tracker tracker) {
+  bound_tracker = tracker;
+  return &TrackingAllocator;
+}
+
+static Tracker current(void) {
+  return bound_tracker;
+}
+
+//query
+static void stats(const Tracker tracker, tracker_stats_t* out) {
+  if (tracker == NULL || out == NULL) {
+    return;
+  }
+
+  *out = tracker->stats;
+}
+
+static size_t call_sites(const Tracker tracker, tracker_call_site_t* sites, size_t max_sites) {
+  size_t count = 0;
+
+  if (tracker == NULL) {
+    return 0;
+  }
+
+  for (size_t i = 0; i < TRACKER_MAX_CALL_SITES; i++) {
+    if (tracker->sites[i].address == NULL) {
+      continue;
+    }
+
+    if (sites != NULL && count < max_sites) {
+      sites[count] = tracker->sites[i];
+    }
+    count++;
+  }
+
+  if (tracker->overflow_site.calls > 0) {
+    if (sites != NULL && count < max_sites) {
+      sites[count] = tracker->overflow_site;
+    }
+    count++;
+  }
+
+  return count;
+}
+
+static void reset_stats(Tracker tracker) {
+  if (tracker == NULL) {
+    return;
+  }
+
+  //live bytes still belong to blocks that will be freed later
+  size_t live_bytes = tracker->stats.live_bytes;
+
+  memset(&tracker->stats, 0, sizeof(tracker->stats));
+  memset(tracker->sites, 0, sizeof(tracker->sites));
+  memset(&tracker->overflow_site, 0, sizeof(tracker->overflow_site));
+
+  tracker->stats.live_bytes = live_bytes;
+  tracker->stats.peak_bytes = live_bytes;
+}
+
+static void dump(const Tracker tracker, FILE* out) {
+  if (tracker == NULL || out == NULL) {
+    return;
+  }
+
+  const tracker_stats_t* s = &tracker->stats;
+
+  fprintf(out, "calls: malloc %zu, realloc %zu, calloc %zu, free %zu, failed %zu\n",
+    s->malloc_calls, s->realloc_calls, s->calloc_calls, s->free_calls, s->failed_calls);
+  fprintf(out, "bytes: live %zu, peak %zu, total requested %zu\n",
+    s->live_bytes, s->peak_bytes, s->total_bytes);
+
+  fprintf(out, "request sizes:\n");
+  for (size_t i = 0; i < TRACKER_HISTOGRAM_BUCKETS; i++) {
+    if (s->size_histogram[i] > 0) {
+      fprintf(out, "  [%zu, %zu): %zu\n", (size_t)1 << i, (size_t)1 << (i + 1), s->size_histogram[i]);
+    }
+  }
+
+  fprintf(out, "call sites:\n");
+  for (size_t i = 0; i < TRACKER_MAX_CALL_SITES; i++) {
+    const tracker_call_site_t* site = &tracker->sites[i];
+    if (site->address != NULL) {
+      fprintf(out, "  %p: calls %zu, reallocs %zu, bytes %zu\n", site->address, site->calls, site->realloc_calls, site->bytes);
+    }
+  }
+
+  if (tracker->overflow_site.calls > 0) {
+    fprintf(out, "  other: calls %zu, reallocs %zu, bytes %zu\n",
+      tracker->overflow_site.calls, tracker->overflow_site.realloc_calls, tracker->overflow_site.bytes);
+  }
+}
+
+//AllocatorInterface
+static void* tracking_malloc(size_t size) {
+  Tracker tracker = bound_tracker;
+  if (tracker == NULL) {
+    return NULL;
+  }
+
+  tracker->stats.malloc_calls++;
+  _record_request(tracker, TRACKER_CALLER(), size, 0);
+
+  return _tracked_malloc(tracker, size);
+}
+
+static void tracking_free(void* ptr) {
+  if (ptr == NULL) {
+    return;
+  }
+
+  tracker_block_t* block = (tracker_block_t*)((char*)ptr - TRACKER_HEADER_SIZE);
+  Tracker tracker = block->tracker;
+
+  tracker->stats.free_calls++;
+  tracker->stats.live_bytes -= block->size;
+  tracker->live_blocks--;
+
+  tracker->inner->free(block);
+
+  if (tracker->destructed && tracker->live_blocks == 0) {
+    DefaultAllocator.free(tracker);
+  }
+}
+
+static void* tracking_realloc(void* ptr, size_t size) {
+  const void* caller = TRACKER_CALLER();
+
+  if (ptr == NULL) {
+    Tracker tracker = bound_tracker;
+    if (tracker == NULL) {
+      return NULL;
+    }
+
+    tracker->stats.realloc_calls++;
+    _record_request(tracker, caller, size, 1);
+    return _tracked_malloc(tracker, size);
+  }
+
+  tracker_block_t* block = (tracker_block_t*)((char*)ptr - TRACKER_HEADER_SIZE);
+  Tracker tracker = block->tracker;
+  size_t old_size = block->size;
+
+  tracker->stats.realloc_calls++;
+  _record_request(tracker, caller, size, 1);
+
+  tracker_block_t* tmp = tracker->inner->realloc(block, TRACKER_HEADER_SIZE + size);
+  if (tmp == NULL) {
+    tracker->stats.failed_calls++;
+    return NULL;
+  }
+
+  tmp->size = size;
+  tracker->stats.live_bytes -= old_size;
+  _add_live(tracker, size);
+
+  return (char*)tmp + TRACKER_HEADER_SIZE;
+}
+
+static void* tracking_calloc(size_t count, size_t size) {
+  Tracker tracker = bound_tracker;
+  if (tracker == NULL) {
+    return NULL;
+  }
+
+  if (size != 0 && count > (size_t)-1 / size) {
+    tracker->stats.failed_calls++;
+    return NULL;
+  }
+
+  tracker->stats.calloc_calls++;
+  _record_request(tracker, TRACKER_CALLER(), count * size, 0);
+
+  void* ptr = _tracked_malloc(tracker, count * size);
+  if (ptr != NULL) {
+    memset(ptr, 0, count * size);
+  }
+
+  return ptr;
+}
+
+AllocatorInterface TrackingAllocator = { tracking_malloc, tracking_free, tracking_realloc, tracking_calloc };
+
+TrackerInterface_t iTracker = {
+  .construct = construct,
+  .destruct = destruct,
+  .bind = bind,
+  .current = current,
+  .stats = stats,
+  .call_sites = call_sites,
+  .reset_stats = reset_stats,
+  .dump = dump
+};
@@ -1,10 +1,28 @@
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
 
 #include "vec_i.h"
 #include "allocator_i.h"
 #include "observer_i.h"
+#include "psort_i.h"
+#include "tpool_i.h"
+#include "simd_scan_i.h"
+#include "file_map_i.h"
+#include "hmap_i.h"
+
 
+typedef struct tagVecShared vec_shared_t;
+typedef struct tagVecBatch vec_batch_t;
+typedef struct tagVecIndex vec_index_t;
 
 struct tagVector {
 	size_t 		size;
@@ -17,31 +35,455 @@ struct tagVector {
 	void 			(*elem_destructor)(void* cb_extra);
 	Observer	observer;
 	const AllocatorInterface* allocator;
+	uint32_t	radix_key_type;
+	size_t		radix_key_offset;
+	size_t		inline_capacity;
+	vec_shared_t*	shared;
+	FileMap		mapping;
+	vec_batch_t*	batch;
+	vec_index_t*	index;
+};
+
+//reference count of a data buffer shared by copies
+struct tagVecShared {
+	atomic_size_t	refs;
+};
+
+//file backed Vec: header, then elements, capacity is whatever the file holds
+#define VEC_MAP_MAGIC					0x31434556u		//"VEC1"
+#define VEC_MAP_VERSION				1
+#define VEC_MAP_HEADER_SIZE		64
+
+typedef struct {
+	uint32_t	magic;
+	uint32_t	version;
+	uint64_t	elem_size;
+	uint64_t	size;
+} vec_map_header_t;
+
+//mutations recorded between begin_batch and commit_batch
+#define VEC_BATCH_ACTIONS			(VEC_ACTION__ADDITION | (VEC_ACTION__REMOVING & ~VEC_ACTION__DESTRUCT) \
+															| VEC_ACTION__SORT | VEC_ACTION__RESIZE)
+#define VEC_BATCH_TAIL				SIZE_MAX
+
+struct tagVecBatch {
+	uint32_t		depth;
+	uint64_t		actions;
+	size_t			operations;
+	size_t			added;
+	size_t			start_size;
+	size_t			range_count;
+	vec_range_t	ranges[VEC_BATCH_MAX_RANGES];
+};
+
+//inline elements start right after the header, in the same block
+#define VEC_INLINE_OFFSET		(((sizeof(struct tagVector) + 15) / 16) * 16)
+
+static int _is_inline(const Vec v) {
+  return v->inline_capacity > 0 && v->data == (char*)v + VEC_INLINE_OFFSET;
+}
+
+//data came from v->allocator, not from the Vec block or a file mapping
+static int _owns_heap_data(const Vec v) {
+  return v->mapping == NULL && !_is_inline(v);
+}
+
+static void _store_mapped_size(Vec v) {
+  if (v->mapping != NULL && iFileMap.writable(v->mapping)) {
+    vec_map_header_t* header = iFileMap.data(v->mapping);
+    header->size = v->size;
+  }
+}
+
+//drops one reference, returns non zero if it was the last one
+static int _release_shared(Vec v) {
+  vec_shared_t* shared = v->shared;
+  v->shared = NULL;
+
+  if (atomic_fetch_sub_explicit(&shared->refs, 1, memory_order_acq_rel) == 1) {
+    v->allocator->free(shared);
+    return 1;
+  }
+
+  return 0;
+}
+
+//every mutation goes through here: read only mappings refuse,
+//and the first mutation of a shared buffer gives this Vec its own copy
+static int32_t _prepare_write(Vec v) {
+  if (v->mapping != NULL && !iFileMap.writable(v->mapping)) {
+    v->error = VEC_ERR__READ_ONLY;
+    return VEC_ERR__READ_ONLY;
+  }
+
+  if (v->shared == NULL) {
+    return VEC_OK;
+  }
+
+  //last owner keeps the buffer as is
+  if (atomic_load_explicit(&v->shared->refs, memory_order_acquire) == 1) {
+    _release_shared(v);
+    return VEC_OK;
+  }
+
+  char* data = v->allocator->malloc(v->capacity * v->elem_size);
+  if (data == NULL) {
+    v->error = VEC_ERR__MALLOC;
+    return VEC_ERR__MALLOC;
+  }
+
+  memcpy(data, v->data, v->size * v->elem_size);
+
+  //other owners may have gone away while copying
+  if (_release_shared(v)) {
+    v->allocator->free(v->data);
+  }
+
+  v->data = data;
+
+  return VEC_OK;
+}
+
+static size_t _upper_bound_index(const Vec v, const void* elem);
+
+//ranges stay sorted and disjoint, touching ones are merged,
+//when there is no room left everything becomes one bounding range
+static void _batch_add_range(vec_batch_t* batch, size_t first, size_t last) {
+  vec_range_t* ranges = batch->ranges;
+  size_t count = batch->range_count;
+
+  //appends keep extending the last range
+  if (count > 0 && first >= ranges[count - 1].first && first <= ranges[count - 1].last) {
+    if (last > ranges[count - 1].last) {
+      ranges[count - 1].last = last;
+    }
+    return;
+  }
+
+  size_t i = 0;
+  while (i < count && ranges[i].last < first) {
+    i++;
+  }
+
+  //overlaps or touches ranges[i..j)
+  size_t j = i;
+  while (j < count && ranges[j].first <= last) {
+    j++;
+  }
+
+  if (j > i) {
+    ranges[i].first = first < ranges[i].first ? first : ranges[i].first;
+    ranges[i].last = last > ranges[j - 1].last ? last : ranges[j - 1].last;
+    memmove(&ranges[i + 1], &ranges[j], (count - j) * sizeof(vec_range_t));
+    batch->range_count = count - (j - i - 1);
+    return;
+  }
+
+  if (count == VEC_BATCH_MAX_RANGES) {
+    ranges[0].first = first < ranges[0].first ? first : ranges[0].first;
+    ranges[0].last = last > ranges[count - 1].last ? last : ranges[count - 1].last;
+    batch->range_count = 1;
+    return;
+  }
+
+  memmove(&ranges[i + 1], &ranges[i], (count - i) * sizeof(vec_range_t));
+  ranges[i].first = first;
+  ranges[i].last = last;
+  batch->range_count = count + 1;
+}
+
+//inserting or erasing in the middle shifts the tail, so the whole tail is dirty
+static void _batch_record(Vec v, int action, const void* extra) {
+  vec_batch_t* batch = v->batch;
+  size_t first = 0;
+  size_t last = VEC_BATCH_TAIL;
+  size_t added = 0;
+
+  switch (action) {
+    case VEC_ACTION__ADD: {
+      const add_action_extra_t* ad = extra;
+      if ((v->flags & VEC_FLAG__ORDERED) == 0) {
+        first = v->size;
+        last = v->size + 1;
+      }
+      else if (v->cmp_fn != NULL) {
+        first = _upper_bound_index(v, ad->elem);
+      }
+      added = 1;
+      break;
+    }
+    case VEC_ACTION__APPEND: {
+      const append_action_extra_t* ad = extra;
+      first = v->size;
+      last = v->size + ad->other->size;
+      added = ad->other->size;
+      break;
+    }
+    case VEC_ACTION__INSERT: {
+      const insert_action_extra_t* id = extra;
+      first = ((char*)id->pos - v->data) / v->elem_size;
+      added = 1;
+      break;
+    }
+    case VEC_ACTION__INSERT_RANGE: {
+      const insert_range_action_extra_t* id = extra;
+      first = ((char*)id->pos - v->data) / v->elem_size;
+      added = id->count;
+      break;
+    }
+    case VEC_ACTION__ERASE: {
+      const erase_action_extra_t* ed = extra;
+      first = ((char*)ed->pos - v->data) / v->elem_size;
+      break;
+    }
+    case VEC_ACTION__ERASE_RANGE: {
+      const erase_range_action_extra_t* ed = extra;
+      first = ((char*)ed->first - v->data) / v->elem_size;
+      break;
+    }
+    case VEC_ACTION__REPLACE: {
+      const replace_action_extra_t* rd = extra;
+      first = ((char*)rd->pos - v->data) / v->elem_size;
+      last = first + 1;
+      break;
+    }
+    case VEC_ACTION__RESIZE: {
+      //growth doesn't touch elements, shrinking drops the tail
+      const resize_action_extra_t* rd = extra;
+      if (rd->new_capacity >= v->size) {
+        return;
+      }
+      first = rd->new_capacity;
+      break;
+    }
+    default:
+      //clear, erase_if, sort
+      break;
+  }
+
+  batch->actions |= action;
+  batch->operations++;
+  batch->added += added;
+  _batch_add_range(batch, first, last);
+}
+
+//observer calls go through here, mutations inside a batch are only recorded
+static int32_t _notify(Vec v, int action, void* extra) {
+  if (v->batch != NULL && (action & VEC_BATCH_ACTIONS)) {
+    _batch_record(v, action, extra);
+    return 0;
+  }
+
+  return iObserver.notify(v->observer, action, extra);
+}
+
+//hash index, key -> index of the first element with that key.
+//Observers run before the change, so the callback sees the old size and elements.
+#define VEC_INDEX_ACTIONS		(VEC_ACTION__ADDITION | (VEC_ACTION__REMOVING & ~VEC_ACTION__DESTRUCT) | VEC_ACTION__SORT \
+														| VEC_ACTION__RESIZE | VEC_ACTION__BATCH | VEC_ACTION__MAKE_ORDERED | VEC_ACTION__RELEASE_DATA)
+
+struct tagVecIndex {
+  Vec         vector;
+  HMap        map;
+  size_t      key_offset;
+  size_t      key_size;
+  hmap_eq_fn  eq;
+  //keys added while already present, removals are only exact without them
+  size_t      duplicates;
+  //changes that shift indices are not tracked, the next lookup rebuilds
+  int         stale;
 };
 
-static Vec construct_with_allocator_and_data(size_t elem_size, AllocatorInterface* allocator, void* data, size_t data_size) {
+static int _index_eq_bytes(const void* first, const void* second, size_t key_size) {
+  return memcmp(first, second, key_size) == 0;
+}
+
+static void _index_add(vec_index_t* index, const char* elem, size_t i) {
+  int32_t inserted;
+  size_t* slot = iHMap.get_or_insert(index->map, elem + index->key_offset, &inserted);
+
+  if (slot == NULL) {
+    index->stale = 1;
+    return;
+  }
+
+  if (inserted) {
+    *slot = i;
+    return;
+  }
+
+  index->duplicates++;
+  if (i < *slot) {
+    *slot = i;
+  }
+}
+
+//0 - another element may have the same key
+static int _index_remove(vec_index_t* index, const char* elem) {
+  if (index->duplicates > 0) {
+    return 0;
+  }
+
+  iHMap.remove(index->map, elem + index->key_offset, NULL);
+  return 1;
+}
+
+static void _index_cb(uint32_t action, const void* extra, void* cb_extra) {
+  vec_index_t* index = cb_extra;
+  Vec v = index->vector;
+  char* end = v->data + (v->size * v->elem_size);
+
+  if (index->stale) {
+    return;
+  }
+
+  switch (action) {
+    case VEC_ACTION__ADD:
+      //ordered add lands anywhere
+      if (!(v->flags & VEC_FLAG__ORDERED)) {
+        _index_add(index, ((const add_action_extra_t*)extra)->elem, v->size);
+        return;
+      }
+      break;
+
+    case VEC_ACTION__APPEND: {
+      Vec other = ((const append_action_extra_t*)extra)->other;
+      for (size_t i = 0; i < other->size; i++) {
+        _index_add(index, other->data + (i * other->elem_size), v->size + i);
+      }
+      return;
+    }
+
+    case VEC_ACTION__INSERT_RANGE: {
+      const insert_range_action_extra_t* id = extra;
+      if (id->pos == end) {
+        for (size_t i = 0; i < id->count; i++) {
+          _index_add(index, (const char*)id->elems + (i * v->elem_size), v->size + i);
+        }
+        return;
+      }
+      break;
+    }
+
+    case VEC_ACTION__ERASE: {
+      //only the last element goes without shifting the rest
+      char* pos = ((const erase_action_extra_t*)extra)->pos;
+      if (pos + v->elem_size == end && _index_remove(index, pos)) {
+        return;
+      }
+      break;
+    }
+
+    case VEC_ACTION__REPLACE: {
+      const replace_action_extra_t* rd = extra;
+      if (_index_remove(index, rd->pos)) {
+        _index_add(index, rd->elem, ((char*)rd->pos - v->data) / v->elem_size);
+        return;
+      }
+      break;
+    }
+
+    case VEC_ACTION__CLEAR:
+      iHMap.clear(index->map);
+      index->duplicates = 0;
+      return;
+
+    case VEC_ACTION__RESIZE:
+      if (((const resize_action_extra_t*)extra)->new_capacity >= v->size) {
+        return;
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  index->stale = 1;
+}
+
+static int32_t _index_rebuild(vec_index_t* index) {
+  Vec v = index->vector;
+
+  iHMap.clear(index->map);
+  index->duplicates = 0;
+  index->stale = 0;
+
+  if (iHMap.reserve(index->map, v->size) < 0) {
+    index->stale = 1;
+    return VEC_ERR__MALLOC;
+  }
+
+  for (size_t i = 0; i < v->size && !index->stale; i++) {
+    _index_add(index, v->data + (i * v->elem_size), i);
+  }
+
+  return index->stale ? VEC_ERR__MALLOC : VEC_OK;
+}
+
+//the observer holding the callback is already gone or unsubscribed
+static void _index_free(Vec v) {
+  if (v->index == NULL) {
+    return;
+  }
+
+  iHMap.destruct(v->index->map);
+  v->allocator->free(v->index);
+  v->index = NULL;
+}
+
+//usable is 0 when the index can't answer: none attached, open batch or failed rebuild
+static char* _index_find(const Vec v, const void* key, int* usable) {
+  vec_index_t* index = v->index;
+
+  *usable = 0;
+  if (index == NULL || v->batch != NULL) {
+    return NULL;
+  }
+
+  if (index->stale && _index_rebuild(index) < 0) {
+    return NULL;
+  }
+
+  *usable = 1;
+  size_t* i = iHMap.get(index->map, key);
+  return i != NULL ? v->data + (*i * v->elem_size) : NULL;
+}
+
+static Vec construct_with_allocator_and_data(size_t elem_size, const AllocatorInterface* allocator, void* data, size_t data_size, size_t inline_capacity) {
 
   if (allocator == NULL) {
-    allocator = &CurrentAllocator;
+    allocator = CurrentAllocator;
   }
 
-  Vec vec = allocator->malloc(sizeof(struct tagVector));
+  if (data != NULL) {
+    inline_capacity = 0;
+  }
+
+  size_t block_size = inline_capacity > 0 ? VEC_INLINE_OFFSET + (inline_capacity * elem_size) : sizeof(struct tagVector);
+  Vec vec = allocator->malloc(block_size);
 
   if (vec == NULL) {
     return NULL;
   }
 
-  if (data == NULL) {
+  if (data != NULL) {
     vec->capacity = data_size;
     vec->size = data_size;
     vec->data = (char*) data;
   }
+  else if (inline_capacity > 0) {
+    vec->capacity = inline_capacity;
+    vec->size = 0;
+    vec->data = (char*)vec + VEC_INLINE_OFFSET;
+  }
   else {
     vec->capacity = 0;
     vec->size = 0;
     vec->data = NULL;
   }
 
+  vec->inline_capacity = inline_capacity;
+
   vec->elem_size = elem_size;
   vec->allocator = allocator;
   vec->observer = NULL;
@@ -49,6 +491,12 @@ static Vec construct_with_allocator_and_data(size_t elem_size, AllocatorInterfac
   vec->cmp_fn = NULL;
   vec->error = 0;
   vec->flags = 0;
+  vec->radix_key_type = VEC_KEY__NONE;
+  vec->radix_key_offset = 0;
+  vec->shared = NULL;
+  vec->mapping = NULL;
+  vec->batch = NULL;
+  vec->index = NULL;
 
   return vec;
 }
@@ -58,28 +506,110 @@ static Vec construct(size_t elem_size) {
   if (elem_size == 0) {
     return NULL;
   }
-  return construct_with_allocator_and_data(elem_size, CurrentAllocator, NULL, 0);
+  return construct_with_allocator_and_data(elem_size, CurrentAllocator, NULL, 0, VEC_INLINE_CAPACITY);
+}
+
+//first inline_capacity elements live inside the Vec block, growth moves them to the heap
+static Vec construct_with_inline_capacity(size_t elem_size, size_t inline_capacity) {
+  if (elem_size == 0) {
+    return NULL;
+  }
+  return construct_with_allocator_and_data(elem_size, CurrentAllocator, NULL, 0, inline_capacity);
 }
 
 static Vec construct_from_data(size_t elem_size, void* data, size_t data_size) {
   if (elem_size == 0 || data == NULL || data_size == NULL) {
     return NULL;
   }
-  return construct_with_allocator_and_data(elem_size, CurrentAllocator, data, data_size);
+  return construct_with_allocator_and_data(elem_size, CurrentAllocator, data, data_size, 0);
 }
 
-static Vec construct_with_allocator(size_t elem_size, AllocatorInterface* allocator) {
+static Vec construct_with_allocator(size_t elem_size, const AllocatorInterface* allocator) {
   if (elem_size == 0 || allocator == NULL) {
     return NULL;
   }
-  return construct_with_allocator_and_data(elem_size, allocator, NULL, 0);
+  return construct_with_allocator_and_data(elem_size, allocator, NULL, 0, VEC_INLINE_CAPACITY);
+}
+
+//elements live in the file, opening doesn't read them, growth extends the file
+static Vec construct_mapped(size_t elem_size, const char* path, uint32_t mode) {
+  if (elem_size == 0 || path == NULL) {
+    return NULL;
+  }
+
+  uint32_t map_flags = FILE_MAP__READ;
+  if (mode & VEC_MAP__CREATE) {
+    map_flags = FILE_MAP__CREATE;
+  }
+  else if (mode & VEC_MAP__READ_WRITE) {
+    map_flags = FILE_MAP__WRITE;
+  }
+
+  FileMap map = iFileMap.open(path, map_flags, VEC_MAP_HEADER_SIZE + (VEC_MIN_SIZE * elem_size));
+  if (map == NULL) {
+    return NULL;
+  }
+
+  vec_map_header_t* header = iFileMap.data(map);
+  size_t length = iFileMap.length(map);
+
+  if (mode & VEC_MAP__CREATE) {
+    header->magic = VEC_MAP_MAGIC;
+    header->version = VEC_MAP_VERSION;
+    header->elem_size = elem_size;
+    header->size = 0;
+  }
+  else if (length < VEC_MAP_HEADER_SIZE || header->magic != VEC_MAP_MAGIC || header->version != VEC_MAP_VERSION
+    || header->elem_size != elem_size || header->size > (length - VEC_MAP_HEADER_SIZE) / elem_size) {
+    iFileMap.close(map);
+    return NULL;
+  }
+
+  Vec v = construct_with_allocator_and_data(elem_size, CurrentAllocator, NULL, 0, 0);
+  if (v == NULL) {
+    iFileMap.close(map);
+    return NULL;
+  }
+
+  v->mapping = map;
+  v->data = (char*)header + VEC_MAP_HEADER_SIZE;
+  v->size = (size_t)header->size;
+  v->capacity = (length - VEC_MAP_HEADER_SIZE) / elem_size;
+  v->flags |= VEC_FLAG__MAPPED;
+
+  return v;
+}
+
+//size goes to the file header, dirty pages to disk
+static int32_t flush(Vec v) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (v->mapping == NULL) {
+    v->error = VEC_ERR__FILE_MAP;
+    return VEC_ERR__FILE_MAP;
+  }
+
+  _store_mapped_size(v);
+
+  if (iFileMap.flush(v->mapping) < 0) {
+    v->error = VEC_ERR__FILE_MAP;
+    return VEC_ERR__FILE_MAP;
+  }
+
+  return VEC_OK;
 }
 
 static int32_t destruct(Vec v) {
 
-  iObserver.notify(v->observer, VEC_ACTION__DESTRUCT, v);
+  _notify(v, VEC_ACTION__DESTRUCT, v);
 
-  if (v->elem_destructor != NULL) {
+  //elements of a shared buffer belong to its last owner
+  int shared = v->shared != NULL;
+  int last_owner = shared ? _release_shared(v) : 1;
+
+  if (v->elem_destructor != NULL && last_owner) {
     for (size_t i = 0; i < v->size; i++) {
       v->elem_destructor(v->data + (i * v->elem_size));
     }
@@ -90,8 +620,23 @@ static int32_t destruct(Vec v) {
     iObserver.destruct(v->observer);
   }
 
-  //destruct data
-  if (v->data != NULL) {
+  if (v->batch != NULL) {
+    v->allocator->free(v->batch);
+  }
+
+  _index_free(v);
+
+  //destruct data, shared buffer goes with its last owner
+  if (shared) {
+    if (last_owner) {
+      v->allocator->free(v->data);
+    }
+  }
+  else if (v->mapping != NULL) {
+    _store_mapped_size(v);
+    iFileMap.close(v->mapping);
+  }
+  else if (v->data != NULL && !_is_inline(v)) {
     v->allocator->free(v->data);
   }
 
@@ -100,17 +645,63 @@ static int32_t destruct(Vec v) {
   allocator->free(v);
 }
 
+int32_t reserve(Vec v, size_t capacity);
+
 //new vector from this
+//heap data is shared with the copy until one of them is modified,
+//inline and file data is copied to the heap. Elements with a destructor own
+//resources a shared buffer can't hand out twice, so they are copied too
 Vec copy(const Vec v) {
-  char* data = v->allocator->malloc(v->size * v->elem_size);
-  if (data == NULL) {
-    v->error = VEC_ERR__MALLOC;
-    return VEC_ERR__MALLOC;
+  if (v->size == 0 || !_owns_heap_data(v) || v->elem_destructor != NULL) {
+    Vec copied = construct_with_allocator_and_data(v->elem_size, v->allocator, NULL, 0, v->inline_capacity);
+    if (copied == NULL) {
+      v->error = VEC_ERR__VECTOR_CONSTRUCT;
+      return NULL;
+    }
+
+    if (v->size > copied->capacity && reserve(copied, v->size) < 0) {
+      destruct(copied);
+      v->error = VEC_ERR__MALLOC;
+      return NULL;
+    }
+
+    _notify(v, VEC_ACTION__COPY, v);
+    if (v->size > 0) {
+      memcpy(copied->data, v->data, v->size * v->elem_size);
+      copied->size = v->size;
+    }
+    return copied;
   }
 
-  iObserver.notify(v->observer, VEC_ACTION__COPY, v);
-  memcpy(data, v->data, v->size * v->elem_size);
-  return construct_from_data(v->elem_size, data, v->size);
+  if (v->shared == NULL) {
+    v->shared = v->allocator->malloc(sizeof(vec_shared_t));
+    if (v->shared == NULL) {
+      v->error = VEC_ERR__MALLOC;
+      return NULL;
+    }
+    atomic_init(&v->shared->refs, 1);
+  }
+
+  Vec copied = construct_with_allocator_and_data(v->elem_size, v->allocator, v->data, v->size, 0);
+  if (copied == NULL) {
+    v->error = VEC_ERR__VECTOR_CONSTRUCT;
+    return NULL;
+  }
+
+  _notify(v, VEC_ACTION__COPY, v);
+
+  atomic_fetch_add_explicit(&v->shared->refs, 1, memory_order_relaxed);
+  copied->shared = v->shared;
+
+  return copied;
+}
+
+static int32_t is_shared(const Vec v) {
+  if (v == NULL) {
+    return 0;
+  }
+
+  return v->shared != NULL && atomic_load_explicit(&v->shared->refs, memory_order_acquire) > 1;
 }
 
 Vec filter(const Vec v, int (*cb)(const void* elem, size_t index, void* extra), void* extra) {
@@ -129,7 +720,7 @@ Vec filter(const Vec v, int (*cb)(const void* elem, size_t index, void* extra),
   }
 
   filter_action_extra_t fd = { v, filtered };
-  iObserver.notify(v->observer, VEC_ACTION__FILTER, &fd);
+  _notify(v, VEC_ACTION__FILTER, &fd);
 
   return filtered;
 }
@@ -153,7 +744,7 @@ Vec slice(const Vec v, size_t begin_index, size_t end_index) {
   Vec slice = construct_from_data(v->elem_size, data, size);
 
   slice_action_extra_t sd = { v, slice };
-  iObserver.notify(v->observer, VEC_ACTION__SLICE, &sd);
+  _notify(v, VEC_ACTION__SLICE, &sd);
 
   return slice;
 }
@@ -185,7 +776,7 @@ int32_t set_flags(Vec v, uint32_t flags) {
 }
 
 int32_t make_static(Vec v) {
-  iObserver.notify(v->observer, VEC_ACTION__MAKE_STATIC, v);
+  _notify(v, VEC_ACTION__MAKE_STATIC, v);
   v->flags |= VEC_FLAG__STATIC;
 }
 
@@ -206,7 +797,7 @@ int32_t make_ordered(Vec v) {
 
   v->flags |= VEC_FLAG__ORDERED;
   sort(v);
-  iObserver.notify(v->observer, VEC_ACTION__MAKE_ORDERED, v);
+  _notify(v, VEC_ACTION__MAKE_ORDERED, v);
 }
 
 size_t elem_size(const Vec v) {
@@ -223,17 +814,52 @@ int32_t set_compare_fn(Vec v, int32_t(*cmp)(const void* first, const void* secon
   v->cmp_fn = cmp;
 }
 
+static int32_t is_shared(const Vec v);
+
 int32_t set_elem_destructor(Vec v, void (*cb)(void* elem)) {
+  //a copy sharing the buffer would destroy or duplicate the same resources
+  if (cb != NULL && is_shared(v)) {
+    v->error = VEC_ERR__SHARED;
+    return VEC_ERR__SHARED;
+  }
+
   v->elem_destructor = cb;
+  return VEC_OK;
 }
 
 void* release_data(Vec v) {
-  iObserver.notify(v->observer, VEC_ACTION__RELEASE_DATA, v);
+  //caller gets a buffer nobody else references
+  if (v->shared != NULL && _prepare_write(v) < 0) {
+    return NULL;
+  }
+
+  _notify(v, VEC_ACTION__RELEASE_DATA, v);
   //destruct observer
   iObserver.destruct(v->observer);
 
+  if (v->batch != NULL) {
+    v->allocator->free(v->batch);
+  }
+
+  _index_free(v);
+
   void* data = v->data;
 
+  //inline storage and mappings go away with the Vec -> hand out a heap copy
+  if (!_owns_heap_data(v)) {
+    data = v->allocator->malloc(v->size * v->elem_size);
+    if (data == NULL) {
+      v->error = VEC_ERR__MALLOC;
+      return NULL;
+    }
+    memcpy(data, v->data, v->size * v->elem_size);
+  }
+
+  if (v->mapping != NULL) {
+    _store_mapped_size(v);
+    iFileMap.close(v->mapping);
+  }
+
   //destruct vec
   AllocatorInterface* allocator = v->allocator;
   allocator->free(v);
@@ -254,8 +880,10 @@ void* get_data_copy(Vec v) {
 }
 
 //capacity
+int32_t resize(Vec v, size_t capacity);
+
 int32_t reserve(Vec v, size_t capacity) {
-  if (size < VEC_MIN_SIZE) {
+  if (capacity < VEC_MIN_SIZE) {
     capacity = VEC_MIN_SIZE;
   }
 
@@ -265,6 +893,10 @@ int32_t reserve(Vec v, size_t capacity) {
       v->error = VEC_ERR__MALLOC;
       return VEC_ERR__MALLOC;
     }
+    v->capacity = capacity;
+  }
+  else if (capacity > v->capacity) {
+    return resize(v, capacity);
   }
 
   return VEC_OK;
@@ -285,18 +917,57 @@ int32_t resize(Vec v, size_t capacity) {
     return VEC_ERR__STATIC_MODE;
   }
 
+  int32_t res = _prepare_write(v);
+  if (res < 0) {
+    return res;
+  }
+
   size_t new_capacity = capacity < VEC_MIN_SIZE ? VEC_MIN_SIZE : capacity;
 
   resize_action_extra_t rd = { v, new_capacity };
-  iObserver.notify(v->observer, VEC_ACTION__RESIZE, &rd);
+  _notify(v, VEC_ACTION__RESIZE, &rd);
 
-  if (new_capacity < v->size) {
+  if (new_capacity < v->size && v->elem_destructor != NULL) {
     for (size_t i = new_capacity; i < v->size; i++) {
       v->elem_destructor(v->data + (i * v->elem_size));
     }
   }
 
-  void* tmp = v->allocator->realloc(v->data, (new_capacity * v->elem_size));
+  size_t kept = new_capacity < v->size ? new_capacity : v->size;
+  void* tmp = NULL;
+
+  //file grows with the mapping, the mapping may move
+  if (v->mapping != NULL) {
+    if (iFileMap.resize(v->mapping, VEC_MAP_HEADER_SIZE + (new_capacity * v->elem_size)) < 0) {
+      v->error = VEC_ERR__FILE_MAP;
+      return VEC_ERR__FILE_MAP;
+    }
+
+    v->data = (char*)iFileMap.data(v->mapping) + VEC_MAP_HEADER_SIZE;
+    v->capacity = new_capacity;
+    v->size = kept;
+    _store_mapped_size(v);
+    return VEC_OK;
+  }
+
+  if (_is_inline(v)) {
+    //still fits the inline storage
+    if (new_capacity <= v->inline_capacity) {
+      v->capacity = new_capacity;
+      v->size = kept;
+      return VEC_OK;
+    }
+
+    //spill to the heap
+    tmp = v->allocator->malloc(new_capacity * v->elem_size);
+    if (tmp != NULL) {
+      memcpy(tmp, v->data, kept * v->elem_size);
+    }
+  }
+  else {
+    tmp = v->allocator->realloc(v->data, (new_capacity * v->elem_size));
+  }
+
   if (tmp == NULL) {
     v->error = VEC_ERR__REALLOC;
     return VEC_ERR__REALLOC;
@@ -352,13 +1023,12 @@ int32_t insert(Vec v, void* pos, void* elem) {
     return VEC_ERR__INVALID_POS;
   }
 
-  //if data not allocated yet -> allocate it
-  if (v->data == NULL) {
-    res = reserve(v, VEC_MIN_SIZE);
-    if (res < 0) {
-      v->error = res;
-      return res;
-    }
+  //position survives realloc and copy on write as an offset
+  size_t offset = (char*)pos - v->data;
+
+  res = _prepare_write(v);
+  if (res < 0) {
+    return res;
   }
 
   //if capacity is full -> realloc
@@ -370,15 +1040,12 @@ int32_t insert(Vec v, void* pos, void* elem) {
     }
   }
 
-  insert_action_extra_t id = { v, pos, elem };
-  iObserver.notify(v->observer, VEC_ACTION__INSERT, &id);
+  pos = v->data + offset;
 
-  char* _pos = (char*)pos;
-  char* last_elem_last_byte = v->data + (v->size * v->elem_size) - 1;
-  for (char* ptr = last_elem_last_byte; ptr >= _pos; ptr--) {
-    ptr[v->elem_size] = *ptr;
-  }
+  insert_action_extra_t id = { v, pos, elem };
+  _notify(v, VEC_ACTION__INSERT, &id);
 
+  memmove((char*)pos + v->elem_size, pos, (v->size * v->elem_size) - offset);
   memcpy(pos, elem, v->elem_size);
   v->size++;
 
@@ -386,30 +1053,59 @@ int32_t insert(Vec v, void* pos, void* elem) {
 }
 
 
-static int32_t _ordered_insert(Vec v, void* elem) {
-  if (v->cmp_fn == NULL) {
-    return VEC_ERR__NULL_CMP_FN;
+//index of the first element not less than elem, data must be ordered by cmp_fn
+static size_t _lower_bound_index(const Vec v, const void* elem) {
+  size_t first = 0;
+  size_t count = v->size;
+
+  while (count > 0) {
+    size_t step = count / 2;
+    size_t mid = first + step;
+
+    if (v->cmp_fn(v->data + (mid * v->elem_size), elem) < 0) {
+      first = mid + 1;
+      count -= step + 1;
+    }
+    else {
+      count = step;
+    }
   }
 
-  char* it = v->data;
-  char* end = v->data + (v->size * v->elem_size);
+  return first;
+}
 
-  for (; it < end; it += v->elem_size) {
-    if (v->cmp_fn(elem, it) > 0) {
-      //insert
-      char* last_elem_last_byte = v->data + (v->size * v->elem_size) - 1;
-      for (char* ptr = last_elem_last_byte; ptr >= it; ptr--) {
-        ptr[v->elem_size] = *ptr;
-      }
-      memcpy(it, elem, v->elem_size);
-      v->size++;
+//index of the first element greater than elem, data must be ordered by cmp_fn
+static size_t _upper_bound_index(const Vec v, const void* elem) {
+  size_t first = 0;
+  size_t count = v->size;
 
-      return VEC_OK;
+  while (count > 0) {
+    size_t step = count / 2;
+    size_t mid = first + step;
+
+    if (v->cmp_fn(elem, v->data + (mid * v->elem_size)) >= 0) {
+      first = mid + 1;
+      count -= step + 1;
+    }
+    else {
+      count = step;
     }
   }
 
-  //push back
-  memcpy(v->data + (v->size * v->elem_size), elem, v->elem_size);
+  return first;
+}
+
+static int32_t _ordered_insert(Vec v, void* elem) {
+  if (v->cmp_fn == NULL) {
+    return VEC_ERR__NULL_CMP_FN;
+  }
+
+  //after equal elements, so equal keys keep insertion order
+  char* it = v->data + (_upper_bound_index(v, elem) * v->elem_size);
+  char* end = v->data + (v->size * v->elem_size);
+
+  memmove(it + v->elem_size, it, end - it);
+  memcpy(it, elem, v->elem_size);
   v->size++;
 
   return VEC_OK;
@@ -428,6 +1124,11 @@ int32_t add(Vec v, void* elem) {
     }
   }
 
+  res = _prepare_write(v);
+  if (res < 0) {
+    return res;
+  }
+
   //if capacity is full -> realloc
   if (v->size == v->capacity) {
     res = resize(v, v->capacity * VEC_REALLOC_SCALE_FACTOR);
@@ -438,7 +1139,7 @@ int32_t add(Vec v, void* elem) {
   }
 
   add_action_extra_t ad = { v, elem };
-  iObserver.notify(v->observer, VEC_ACTION__ADD, &ad);
+  _notify(v, VEC_ACTION__ADD, &ad);
 
   if (v->flags & VEC_FLAG__ORDERED) {
     return _ordered_insert(v, elem);
@@ -471,6 +1172,11 @@ int32_t append(Vec v, const Vec other) {
     }
   }
 
+  res = _prepare_write(v);
+  if (res < 0) {
+    return res;
+  }
+
   //aquire needed capasity
   size_t needed_capacity = v->size + other->size;
   if (needed_capacity > v->capacity) {
@@ -482,9 +1188,98 @@ int32_t append(Vec v, const Vec other) {
   }
 
   append_action_extra_t ad = { v, other };
-  iObserver.notify(v->observer, VEC_ACTION__APPEND, &ad);
+  _notify(v, VEC_ACTION__APPEND, &ad);
+
+  memcpy(v->data + (v->size * v->elem_size), other->data, other->elem_size * other->size);
+  v->size += other->size;
+
+  return VEC_OK;
+}
+
+static int32_t insert_range(Vec v, void* pos, const void* src, size_t count) {
+  int32_t res = 0;
+
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (v->flags & VEC_FLAG__ORDERED) {
+    v->error = VEC_ERR__ORDERED_MODE;
+    return VEC_ERR__ORDERED_MODE;
+  }
+
+  if (src == NULL) {
+    v->error = VEC_ERR__NULL_ELEM;
+    return VEC_ERR__NULL_ELEM;
+  }
+
+  //end position is allowed here, it means append
+  char* end = v->data + (v->size * v->elem_size);
+  if ((char*)pos < v->data || (char*)pos > end || (((char*)pos - v->data) % v->elem_size) != 0) {
+    v->error = VEC_ERR__INVALID_POS;
+    return VEC_ERR__INVALID_POS;
+  }
+
+  if (count == 0) {
+    return VEC_OK;
+  }
+
+  //src inside the vector is kept as an offset: growing moves it, the shift below splits it
+  size_t bytes = count * v->elem_size;
+  int inner = (const char*)src >= v->data && (const char*)src < end;
+  size_t src_offset = inner ? (size_t)((const char*)src - v->data) : 0;
+  if (inner && src_offset + bytes > (size_t)(end - v->data)) {
+    v->error = VEC_ERR__INVALID_POS;
+    return VEC_ERR__INVALID_POS;
+  }
 
-  memcpy(&v->data + (v->size * v->elem_size), &other->data, other->elem_size * other->size);
+  size_t offset = (char*)pos - v->data;
+  size_t needed_capacity = v->size + count;
+
+  res = _prepare_write(v);
+  if (res < 0) {
+    return res;
+  }
+
+  //grow once for the whole range
+  if (needed_capacity > v->capacity) {
+    size_t new_capacity = v->capacity * VEC_REALLOC_SCALE_FACTOR;
+    if (new_capacity < needed_capacity) {
+      new_capacity = needed_capacity;
+    }
+
+    res = v->data == NULL ? reserve(v, new_capacity) : resize(v, new_capacity);
+    if (res < 0) {
+      v->error = res;
+      return res;
+    }
+  }
+
+  pos = v->data + offset;
+  if (inner) {
+    src = v->data + src_offset;
+  }
+
+  insert_range_action_extra_t id = { v, pos, src, count };
+  _notify(v, VEC_ACTION__INSERT_RANGE, &id);
+
+  memmove((char*)pos + bytes, pos, (v->size * v->elem_size) - offset);
+
+  if (inner) {
+    //part in front of pos stayed, the rest moved up by bytes
+    size_t before = 0;
+    if (src_offset < offset) {
+      before = (src_offset + bytes < offset ? src_offset + bytes : offset) - src_offset;
+      memcpy(pos, v->data + src_offset, before);
+    }
+
+    size_t moved = (src_offset > offset ? src_offset : offset) + bytes;
+    memcpy((char*)pos + before, v->data + moved, bytes - before);
+  }
+  else {
+    memcpy(pos, src, bytes);
+  }
+  v->size += count;
 
   return VEC_OK;
 }
@@ -492,7 +1287,7 @@ int32_t append(Vec v, const Vec other) {
 
 //removing
 int32_t clear(Vec v) {
-  iObserver.notify(v->observer, VEC_ACTION__CLEAR, &v);
+  _notify(v, VEC_ACTION__CLEAR, v);
 
   v->size = 0;
   return VEC_OK;
@@ -513,18 +1308,26 @@ int32_t erase(Vec v, void* pos) {
     return VEC_ERR__INVALID_POS;
   }
 
+  size_t offset = (char*)pos - v->data;
+  int32_t res = _prepare_write(v);
+  if (res < 0) {
+    return res;
+  }
+
+  pos = v->data + offset;
+
   erase_action_extra_t ed = { v, pos };
-  iObserver.notify(v->observer, VEC_ACTION__ERASE, &ed);
+  _notify(v, VEC_ACTION__ERASE, &ed);
 
   char* _pos = pos;
-  char* last_elem = v->data + ((v->size - 1) * v->elem_size);
-
-  v->elem_destructor(pos);
+  char* end = v->data + (v->size * v->elem_size);
 
-  for (char* ptr = _pos; ptr < last_elem; ptr++) {
-    *ptr = ptr[v->elem_size];
+  if (v->elem_destructor != NULL) {
+    v->elem_destructor(pos);
   }
 
+  memmove(_pos, _pos + v->elem_size, end - _pos - v->elem_size);
+
   v->size--;
 
   return VEC_OK;
@@ -543,11 +1346,118 @@ int32_t erase_at(Vec v, size_t index) {
 
   char* pos = v->data + (index * v->elem_size);
 
-  v->elem_destructor(pos);
   return erase(v, pos);
 }
 
 
+static int32_t erase_range(Vec v, void* first, void* last) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (first == NULL || last == NULL) {
+    v->error = VEC_ERR__NULL_POS;
+    return VEC_ERR__NULL_POS;
+  }
+
+  char* _first = first;
+  char* _last = last;
+  char* end = v->data + (v->size * v->elem_size);
+
+  if (_first < v->data || _last > end || _first > _last
+    || ((_first - v->data) % v->elem_size) != 0 || ((_last - v->data) % v->elem_size) != 0) {
+    v->error = VEC_ERR__INVALID_POS;
+    return VEC_ERR__INVALID_POS;
+  }
+
+  if (_first == _last) {
+    return VEC_OK;
+  }
+
+  size_t first_offset = _first - v->data;
+  size_t last_offset = _last - v->data;
+  int32_t res = _prepare_write(v);
+  if (res < 0) {
+    return res;
+  }
+
+  first = _first = v->data + first_offset;
+  last = _last = v->data + last_offset;
+  end = v->data + (v->size * v->elem_size);
+
+  erase_range_action_extra_t ed = { v, first, last, (_last - _first) / v->elem_size };
+  _notify(v, VEC_ACTION__ERASE_RANGE, &ed);
+
+  if (v->elem_destructor != NULL) {
+    for (char* ptr = _first; ptr < _last; ptr += v->elem_size) {
+      v->elem_destructor(ptr);
+    }
+  }
+
+  memmove(_first, _last, end - _last);
+  v->size -= ed.count;
+
+  return VEC_OK;
+}
+
+//removes every element pred() returns non zero for, returns removed count
+static int32_t erase_if(Vec v, int (*pred)(const void* elem, size_t index, void* extra), void* extra) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (pred == NULL) {
+    v->error = VEC_ERR__NULL_CALLBACK;
+    return VEC_ERR__NULL_CALLBACK;
+  }
+
+  int32_t res = _prepare_write(v);
+  if (res < 0) {
+    return res;
+  }
+
+  erase_if_action_extra_t ed = { v, pred, extra };
+  _notify(v, VEC_ACTION__ERASE_IF, &ed);
+
+  //kept elements are moved down in runs, one memmove per run
+  char* write = v->data;
+  char* run_begin = v->data;
+  size_t kept = 0;
+
+  for (size_t i = 0; i < v->size; i++) {
+    char* ptr = v->data + (i * v->elem_size);
+
+    if (pred(ptr, i, extra) == 0) {
+      kept++;
+      continue;
+    }
+
+    if (ptr > run_begin) {
+      if (write != run_begin) {
+        memmove(write, run_begin, ptr - run_begin);
+      }
+      write += ptr - run_begin;
+    }
+
+    if (v->elem_destructor != NULL) {
+      v->elem_destructor(ptr);
+    }
+
+    run_begin = ptr + v->elem_size;
+  }
+
+  char* end = v->data + (v->size * v->elem_size);
+  if (end > run_begin && write != run_begin) {
+    memmove(write, run_begin, end - run_begin);
+  }
+
+  int32_t removed = (int32_t)(v->size - kept);
+  v->size = kept;
+
+  return removed;
+}
+
+
 //access
 void* at(const Vec v, size_t index) {
 
@@ -631,6 +1541,12 @@ int32_t for_each(Vec v, void (*cb)(void* elem, size_t index, void* extra), void*
     return VEC_ERR__EMPTY_VEC;
   }
 
+  //callback may write to the elements
+  int32_t res = _prepare_write(v);
+  if (res < 0) {
+    return res;
+  }
+
   char* ptr = NULL;
   for (size_t i = 0; i < v->size; i++) {
     ptr = v->data + (i * v->elem_size);
@@ -640,119 +1556,1561 @@ int32_t for_each(Vec v, void (*cb)(void* elem, size_t index, void* extra), void*
   return VEC_OK;
 }
 
-int32_t find(const Vec v, void* elem, int (*cmp)(void* first, void* second)) {
+//views, no copy: valid until the parent is modified or destructed
+static int32_t view(const Vec v, size_t begin_index, size_t end_index, vec_view_t* out) {
   if (v == NULL) {
     return VEC_ERR__NULL_VEC;
   }
 
-  if (cmp == NULL) {
-    cmp = v->cmp_fn;
-
-    if (cmp == NULL) {
-      v->error = VEC_ERR__NULL_CALLBACK;
-      return VEC_ERR__NULL_CALLBACK;
-    }
+  if (out == NULL) {
+    v->error = VEC_ERR__NULL_POS;
+    return VEC_ERR__NULL_POS;
   }
 
-  if (v->size == 0) {
-    v->error = VEC_ERR__EMPTY_VEC;
-    return VEC_ERR__EMPTY_VEC;
+  if (begin_index > end_index || end_index > v->size) {
+    v->error = VEC_ERR__INVALID_INDEX;
+    return VEC_ERR__INVALID_INDEX;
   }
 
-  char* ptr = NULL;
-  for (size_t i = 0; i < v->size; i++) {
-    ptr = v->data + (i * v->elem_size);
-    if (cmp(ptr, elem) == 0) {
-      return ptr;
-    }
-  }
+  out->parent = v;
+  out->data = v->data + (begin_index * v->elem_size);
+  out->size = end_index - begin_index;
+  out->elem_size = v->elem_size;
 
-  return NULL;
+  return VEC_OK;
 }
 
-
-//modification
-int32_t replace(Vec v, void* pos, void* elem) {
-
-  if (v == NULL) {
-    return VEC_ERR__NULL_POS;
-  }
-
-  if (pos == NULL) {
-    v->error = VEC_ERR__NULL_POS;
+static int32_t subview(const vec_view_t* view, size_t begin_index, size_t end_index, vec_view_t* out) {
+  if (view == NULL || out == NULL) {
     return VEC_ERR__NULL_POS;
   }
 
-  if (!_is_correct_pos(v, pos)) {
-    v->error = VEC_ERR__INVALID_POS;
-    return VEC_ERR__INVALID_POS;
+  if (begin_index > end_index || end_index > view->size) {
+    return VEC_ERR__INVALID_INDEX;
   }
 
-  replace_action_extra_t rd = { v, pos, elem};
-  iObserver.notify(v->observer, VEC_ACTION__REPLACE, &rd);
+  out->parent = view->parent;
+  out->data = view->data + (begin_index * view->elem_size);
+  out->size = end_index - begin_index;
+  out->elem_size = view->elem_size;
 
-  v->elem_destructor(pos);
-  memcpy(pos, elem, v->elem_size);
   return VEC_OK;
 }
 
-int32_t replace_at(Vec v, size_t index, void* elem) {
+static const void* view_at(const vec_view_t* view, size_t index) {
+  if (view == NULL || index >= view->size) {
+    return NULL;
+  }
 
+  return view->data + (index * view->elem_size);
+}
+
+//owning Vec with the viewed elements
+static Vec view_to_vec(const vec_view_t* view) {
+  if (view == NULL || view->parent == NULL) {
+    return NULL;
+  }
+
+  Vec v = construct_with_allocator_and_data(view->elem_size, view->parent->allocator, NULL, 0, 0);
   if (v == NULL) {
-    return VEC_ERR__NULL_POS;
+    return NULL;
   }
 
-  if (index >= v->size) {
-    v->error = VEC_ERR__INVALID_INDEX;
-    return VEC_ERR__INVALID_INDEX;
+  if (view->size > 0 && insert_range(v, NULL, view->data, view->size) < 0) {
+    destruct(v);
+    return NULL;
   }
 
-  char* pos = v->data + (index * v->elem_size);
-  return replace(v, pos, elem);
+  return v;
 }
 
-int32_t sort(Vec v) {
+//parallel, chunks run on iThreadPool.default_pool()
+typedef struct {
+  Vec     v;
+  size_t  grain;
+  void*   extra;
+  void    (*for_each_cb)(void* elem, size_t index, void* extra);
+  void    (*combine)(void* acc, const void* elem, void* extra);
+  int     (*filter_cb)(const void* elem, size_t index, void* extra);
+  char*   partials;
+  char**  buffers;
+  size_t* counts;
+  size_t* offsets;
+  char*   out;
+} par_ctx_t;
+
+static size_t _par_grain(const Vec v, ThreadPool pool, size_t grain) {
+  if (grain > 0) {
+    return grain;
+  }
+
+  size_t chunks = iThreadPool.threads(pool) * VEC_PAR_CHUNKS_PER_THREAD;
+  grain = v->size / chunks;
+  return grain < VEC_PAR_MIN_GRAIN ? VEC_PAR_MIN_GRAIN : grain;
+}
+
+static void _par_for_each_body(size_t begin, size_t end, void* arg) {
+  par_ctx_t* ctx = arg;
+  Vec v = ctx->v;
 
+  for (size_t i = begin; i < end; i++) {
+    ctx->for_each_cb(v->data + (i * v->elem_size), i, ctx->extra);
+  }
+}
+
+static int32_t par_for_each(Vec v, void (*cb)(void* elem, size_t index, void* extra), void* extra, size_t grain) {
   if (v == NULL) {
-    return VEC_ERR__NULL_POS;
+    return VEC_ERR__NULL_VEC;
   }
 
-  if (v->cmp_fn == NULL) {
-    v->error = VEC_ERR__NULL_CMP_FN;
-    return VEC_ERR__NULL_CMP_FN;
+  if (cb == NULL) {
+    v->error = VEC_ERR__NULL_CALLBACK;
+    return VEC_ERR__NULL_CALLBACK;
   }
 
-  iObserver.notify(v->observer, VEC_ACTION__SORT, v);
+  if (v->size == 0) {
+    v->error = VEC_ERR__EMPTY_VEC;
+    return VEC_ERR__EMPTY_VEC;
+  }
 
-  qsort(v->data, v->size, v->elem_size, v->cmp_fn);
-}
+  ThreadPool pool = iThreadPool.default_pool();
+  if (pool == NULL) {
+    return for_each(v, cb, extra);
+  }
 
-//notification
-int32_t subscribe(Vec v, uint64_t action_mask, void (*cb)(uint64_t action_flag, const void* calling_extra, void* cb_extra), void* cb_extra, int auto_free_extra) {
-  if (v->observer == NULL) {
-    v->observer = iObserver.construct();
-    if (v->observer) {
-      v->error = VEC_ERR__OBSERVER_CONSTRUCT;
-      return VEC_ERR__OBSERVER_CONSTRUCT;
-    }
+  int32_t res = _prepare_write(v);
+  if (res < 0) {
+    return res;
   }
 
-  return iObserver.subscribe(v->observer, action_mask, cb, cb_extra, auto_free_extra);
+  par_ctx_t ctx = { .v = v, .extra = extra, .for_each_cb = cb };
+  if (iThreadPool.parallel_for(pool, v->size, _par_grain(v, pool, grain), _par_for_each_body, &ctx) < 0) {
+    v->error = VEC_ERR__MALLOC;
+    return VEC_ERR__MALLOC;
+  }
+
+  return VEC_OK;
 }
 
-void*  unsubscribe(Vec v, uint64_t action_mask, void (*cb)(uint64_t action_flag, const void* calling_extra, void* cb_extra)) {
-  return iObserver.unsubscribe(v->observer, action_mask, cb);
+static void _par_reduce_body(size_t begin, size_t end, void* arg) {
+  par_ctx_t* ctx = arg;
+  Vec v = ctx->v;
+  char* acc = ctx->partials + ((begin / ctx->grain) * v->elem_size);
+
+  for (size_t i = begin; i < end; i++) {
+    ctx->combine(acc, v->data + (i * v->elem_size), ctx->extra);
+  }
 }
 
-VectorInterface iVec = {
-  .construct = construct,
-  .construct_from_data = construct_from_data,
-  .construct_with_allocator = construct_with_allocator,
-  .destruct = destruct,
+//init is the identity element on input and the result on output,
+//combine must be associative, partial results are combined in index order
+static int32_t par_reduce(const Vec v, void* init, void (*combine)(void* acc, const void* elem, void* extra), void* extra) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
 
-  .copy = copy,
-  .filter = filter,
-  .slice = slice,
+  if (init == NULL) {
+    v->error = VEC_ERR__NULL_ELEM;
+    return VEC_ERR__NULL_ELEM;
+  }
+
+  if (combine == NULL) {
+    v->error = VEC_ERR__NULL_CALLBACK;
+    return VEC_ERR__NULL_CALLBACK;
+  }
+
+  if (v->size == 0) {
+    return VEC_OK;
+  }
+
+  ThreadPool pool = iThreadPool.default_pool();
+  size_t grain = pool == NULL ? v->size : _par_grain(v, pool, 0);
+  size_t chunks = (v->size + grain - 1) / grain;
+
+  if (chunks == 1) {
+    for (size_t i = 0; i < v->size; i++) {
+      combine(init, v->data + (i * v->elem_size), extra);
+    }
+    return VEC_OK;
+  }
+
+  par_ctx_t ctx = { .v = v, .grain = grain, .extra = extra, .combine = combine };
+  ctx.partials = v->allocator->malloc(chunks * v->elem_size);
+  if (ctx.partials == NULL) {
+    v->error = VEC_ERR__MALLOC;
+    return VEC_ERR__MALLOC;
+  }
+
+  for (size_t i = 0; i < chunks; i++) {
+    memcpy(ctx.partials + (i * v->elem_size), init, v->elem_size);
+  }
+
+  int32_t res = iThreadPool.parallel_for(pool, v->size, grain, _par_reduce_body, &ctx);
+  if (res == TPOOL_OK) {
+    for (size_t i = 0; i < chunks; i++) {
+      combine(init, ctx.partials + (i * v->elem_size), extra);
+    }
+  }
+
+  v->allocator->free(ctx.partials);
+
+  if (res < 0) {
+    v->error = VEC_ERR__MALLOC;
+    return VEC_ERR__MALLOC;
+  }
+
+  return VEC_OK;
+}
+
+//pass 1: every chunk filters into its own buffer
+static void _par_filter_body(size_t begin, size_t end, void* arg) {
+  par_ctx_t* ctx = arg;
+  Vec v = ctx->v;
+  size_t chunk = begin / ctx->grain;
+
+  char* buffer = v->allocator->malloc((end - begin) * v->elem_size);
+  ctx->buffers[chunk] = buffer;
+  ctx->counts[chunk] = 0;
+
+  if (buffer == NULL) {
+    return;
+  }
+
+  size_t count = 0;
+  for (size_t i = begin; i < end; i++) {
+    char* elem = v->data + (i * v->elem_size);
+    if (ctx->filter_cb(elem, i, ctx->extra) == 0) {
+      memcpy(buffer + (count * v->elem_size), elem, v->elem_size);
+      count++;
+    }
+  }
+
+  ctx->counts[chunk] = count;
+}
+
+//pass 2: buffers are copied to offsets from the prefix sum of their counts
+static void _par_filter_copy_body(size_t begin, size_t end, void* arg) {
+  par_ctx_t* ctx = arg;
+  size_t elem_size = ctx->v->elem_size;
+
+  for (size_t chunk = begin; chunk < end; chunk++) {
+    memcpy(ctx->out + (ctx->offsets[chunk] * elem_size), ctx->buffers[chunk], ctx->counts[chunk] * elem_size);
+  }
+}
+
+//same contract as filter (keeps elements cb returns 0 for), order is preserved
+static Vec par_filter(const Vec v, int (*cb)(const void* elem, size_t index, void* extra), void* extra, size_t grain) {
+  if (v == NULL) {
+    return NULL;
+  }
+
+  if (cb == NULL) {
+    v->error = VEC_ERR__NULL_CALLBACK;
+    return NULL;
+  }
+
+  ThreadPool pool = iThreadPool.default_pool();
+  if (pool == NULL || v->size == 0) {
+    return filter(v, cb, extra);
+  }
+
+  grain = _par_grain(v, pool, grain);
+  size_t chunks = (v->size + grain - 1) / grain;
+
+  par_ctx_t ctx = { .v = v, .grain = grain, .extra = extra, .filter_cb = cb };
+  ctx.buffers = v->allocator->calloc(chunks, sizeof(char*));
+  ctx.counts = v->allocator->malloc(chunks * sizeof(size_t) * 2);
+
+  Vec filtered = NULL;
+  int32_t res = VEC_ERR__MALLOC;
+
+  if (ctx.buffers == NULL || ctx.counts == NULL) {
+    goto cleanup;
+  }
+
+  ctx.offsets = ctx.counts + chunks;
+
+  if (iThreadPool.parallel_for(pool, v->size, grain, _par_filter_body, &ctx) < 0) {
+    goto cleanup;
+  }
+
+  size_t total = 0;
+  for (size_t i = 0; i < chunks; i++) {
+    if (ctx.buffers[i] == NULL) {
+      goto cleanup;
+    }
+    ctx.offsets[i] = total;
+    total += ctx.counts[i];
+  }
+
+  filtered = construct(v->elem_size);
+  if (filtered == NULL) {
+    res = VEC_ERR__VECTOR_CONSTRUCT;
+    goto cleanup;
+  }
+
+  if (total > 0) {
+    if (reserve(filtered, total) < 0) {
+      destruct(filtered);
+      filtered = NULL;
+      goto cleanup;
+    }
+
+    ctx.out = filtered->data;
+    if (iThreadPool.parallel_for(pool, chunks, 1, _par_filter_copy_body, &ctx) < 0) {
+      destruct(filtered);
+      filtered = NULL;
+      goto cleanup;
+    }
+    filtered->size = total;
+  }
+
+  res = VEC_OK;
+
+  filter_action_extra_t fd = { v, filtered };
+  _notify(v, VEC_ACTION__FILTER, &fd);
+
+cleanup:
+  if (ctx.buffers != NULL) {
+    for (size_t i = 0; i < chunks; i++) {
+      if (ctx.buffers[i] != NULL) {
+        v->allocator->free(ctx.buffers[i]);
+      }
+    }
+    v->allocator->free(ctx.buffers);
+  }
+
+  if (ctx.counts != NULL) {
+    v->allocator->free(ctx.counts);
+  }
+
+  if (res < 0) {
+    v->error = res;
+  }
+
+  return filtered;
+}
+
+void* find(const Vec v, void* elem, int (*cmp)(void* first, void* second)) {
+  if (v == NULL) {
+    return NULL;
+  }
+
+  int ordered = (v->flags & VEC_FLAG__ORDERED) && v->cmp_fn != NULL && (cmp == NULL || (void*)cmp == (void*)v->cmp_fn);
+
+  //hash index, only for the vector's own compare fn: equal keys are promised for it alone.
+  //Skipped when a rebuild would cost more than the binary search below
+  int own_cmp = v->cmp_fn != NULL && (cmp == NULL || (void*)cmp == (void*)v->cmp_fn);
+  if (v->index != NULL && elem != NULL && own_cmp && !(ordered && v->index->stale)) {
+    int usable;
+    char* ptr = _index_find(v, (char*)elem + v->index->key_offset, &usable);
+
+    if (usable) {
+      //no key -> no equal element
+      if (ptr == NULL) {
+        return NULL;
+      }
+
+      //with duplicate keys the hit may not be the first match, the scan finds that one
+      if (v->index->duplicates == 0 && v->cmp_fn(ptr, elem) == 0) {
+        return ptr;
+      }
+    }
+  }
+
+  //ordered by the same compare fn -> binary search
+  if (ordered) {
+    size_t index = _lower_bound_index(v, elem);
+    char* ptr = v->data + (index * v->elem_size);
+
+    if (index < v->size && v->cmp_fn(ptr, elem) == 0) {
+      return ptr;
+    }
+
+    return NULL;
+  }
+
+  if (cmp == NULL) {
+    cmp = (int (*)(void*, void*))v->cmp_fn;
+
+    if (cmp == NULL) {
+      v->error = VEC_ERR__NULL_CALLBACK;
+      return NULL;
+    }
+  }
+
+  if (v->size == 0) {
+    v->error = VEC_ERR__EMPTY_VEC;
+    return NULL;
+  }
+
+  char* ptr = NULL;
+  for (size_t i = 0; i < v->size; i++) {
+    ptr = v->data + (i * v->elem_size);
+    if (cmp(ptr, elem) == 0) {
+      return ptr;
+    }
+  }
+
+  return NULL;
+}
+
+//bytewise scans, elem_size must be 1, 2, 4 or 8
+static int32_t _check_scan(const Vec v, const void* elem) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (elem == NULL) {
+    v->error = VEC_ERR__NULL_ELEM;
+    return VEC_ERR__NULL_ELEM;
+  }
+
+  if (v->elem_size != 1 && v->elem_size != 2 && v->elem_size != 4 && v->elem_size != 8) {
+    v->error = VEC_ERR__UNSUPPORTED_ELEM_SIZE;
+    return VEC_ERR__UNSUPPORTED_ELEM_SIZE;
+  }
+
+  return VEC_OK;
+}
+
+static void* find_bytes(const Vec v, const void* elem) {
+  if (_check_scan(v, elem) < 0 || v->size == 0) {
+    return NULL;
+  }
+
+  size_t index = iSimdScan.find(v->data, v->size, v->elem_size, elem, 0);
+  return index < v->size ? v->data + (index * v->elem_size) : NULL;
+}
+
+static int64_t count_equal(const Vec v, const void* elem) {
+  int32_t res = _check_scan(v, elem);
+  if (res < 0) {
+    return res;
+  }
+
+  if (v->size == 0) {
+    return 0;
+  }
+
+  return (int64_t)iSimdScan.count_equal(v->data, v->size, v->elem_size, elem);
+}
+
+//Vec of size_t indices of all elements equal to elem
+static Vec find_all_indices(const Vec v, const void* elem) {
+  if (_check_scan(v, elem) < 0) {
+    return NULL;
+  }
+
+  Vec indices = construct(sizeof(size_t));
+  if (indices == NULL) {
+    v->error = VEC_ERR__VECTOR_CONSTRUCT;
+    return NULL;
+  }
+
+  if (v->size == 0) {
+    return indices;
+  }
+
+  //counting first gives the exact size, the scan is cheap compared to a second realloc
+  size_t count = iSimdScan.count_equal(v->data, v->size, v->elem_size, elem);
+  if (count == 0) {
+    return indices;
+  }
+
+  if (reserve(indices, count) < 0) {
+    destruct(indices);
+    v->error = VEC_ERR__MALLOC;
+    return NULL;
+  }
+
+  indices->size = iSimdScan.find_all(v->data, v->size, v->elem_size, elem, (size_t*)indices->data);
+
+  return indices;
+}
+
+static int32_t _check_ordered(const Vec v) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (v->cmp_fn == NULL) {
+    v->error = VEC_ERR__NULL_CMP_FN;
+    return VEC_ERR__NULL_CMP_FN;
+  }
+
+  if ((v->flags & VEC_FLAG__ORDERED) == 0) {
+    v->error = VEC_ERR__NOT_ORDERED;
+    return VEC_ERR__NOT_ORDERED;
+  }
+
+  return VEC_OK;
+}
+
+//first element not less than elem, end() if there is none
+static void* lower_bound(const Vec v, const void* elem) {
+  if (_check_ordered(v) < 0) {
+    return NULL;
+  }
+
+  return v->data + (_lower_bound_index(v, elem) * v->elem_size);
+}
+
+//first element greater than elem, end() if there is none
+static void* upper_bound(const Vec v, const void* elem) {
+  if (_check_ordered(v) < 0) {
+    return NULL;
+  }
+
+  return v->data + (_upper_bound_index(v, elem) * v->elem_size);
+}
+
+//[first, last) range of elements equal to elem, returns its length
+static int32_t equal_range(const Vec v, const void* elem, void** first, void** last) {
+  int32_t res = _check_ordered(v);
+  if (res < 0) {
+    return res;
+  }
+
+  size_t lower = _lower_bound_index(v, elem);
+  size_t upper = lower;
+
+  if (lower < v->size && v->cmp_fn(v->data + (lower * v->elem_size), elem) == 0) {
+    upper = _upper_bound_index(v, elem);
+  }
+
+  if (first != NULL) {
+    *first = v->data + (lower * v->elem_size);
+  }
+
+  if (last != NULL) {
+    *last = v->data + (upper * v->elem_size);
+  }
+
+  return (int32_t)(upper - lower);
+}
+
+static int32_t contains(const Vec v, const void* elem) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (v->cmp_fn == NULL) {
+    v->error = VEC_ERR__NULL_CMP_FN;
+    return VEC_ERR__NULL_CMP_FN;
+  }
+
+  if (v->size == 0) {
+    return 0;
+  }
+
+  return find(v, (void*)elem, NULL) != NULL;
+}
+
+
+//modification
+int32_t replace(Vec v, void* pos, void* elem) {
+
+  if (v == NULL) {
+    return VEC_ERR__NULL_POS;
+  }
+
+  if (pos == NULL) {
+    v->error = VEC_ERR__NULL_POS;
+    return VEC_ERR__NULL_POS;
+  }
+
+  if (!_is_correct_pos(v, pos)) {
+    v->error = VEC_ERR__INVALID_POS;
+    return VEC_ERR__INVALID_POS;
+  }
+
+  size_t offset = (char*)pos - v->data;
+  int32_t res = _prepare_write(v);
+  if (res < 0) {
+    return res;
+  }
+
+  pos = v->data + offset;
+
+  replace_action_extra_t rd = { v, pos, elem};
+  _notify(v, VEC_ACTION__REPLACE, &rd);
+
+  if (v->elem_destructor != NULL) {
+    v->elem_destructor(pos);
+  }
+  memcpy(pos, elem, v->elem_size);
+  return VEC_OK;
+}
+
+int32_t replace_at(Vec v, size_t index, void* elem) {
+
+  if (v == NULL) {
+    return VEC_ERR__NULL_POS;
+  }
+
+  if (index >= v->size) {
+    v->error = VEC_ERR__INVALID_INDEX;
+    return VEC_ERR__INVALID_INDEX;
+  }
+
+  char* pos = v->data + (index * v->elem_size);
+  return replace(v, pos, elem);
+}
+
+static size_t _radix_key_size(uint32_t key_type) {
+  switch (key_type) {
+    case VEC_KEY__U32:
+    case VEC_KEY__I32:
+    case VEC_KEY__F32:
+      return 4;
+    case VEC_KEY__U64:
+    case VEC_KEY__I64:
+    case VEC_KEY__F64:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+//key mapped to unsigned so that its byte order is the numeric order
+static inline uint64_t _radix_key(const char* elem, uint32_t key_type) {
+  uint32_t u32;
+  uint64_t u64;
+
+  switch (key_type) {
+    case VEC_KEY__U32:
+      memcpy(&u32, elem, 4);
+      return u32;
+    case VEC_KEY__I32:
+      memcpy(&u32, elem, 4);
+      return u32 ^ 0x80000000u;
+    case VEC_KEY__F32:
+      memcpy(&u32, elem, 4);
+      return u32 ^ ((u32 >> 31) ? 0xFFFFFFFFu : 0x80000000u);
+    case VEC_KEY__U64:
+      memcpy(&u64, elem, 8);
+      return u64;
+    case VEC_KEY__I64:
+      memcpy(&u64, elem, 8);
+      return u64 ^ 0x8000000000000000ull;
+    case VEC_KEY__F64:
+      memcpy(&u64, elem, 8);
+      return u64 ^ ((u64 >> 63) ? 0xFFFFFFFFFFFFFFFFull : 0x8000000000000000ull);
+    default:
+      return 0;
+  }
+}
+
+//LSD radix sort by 8 bit digits, stable. SORT is notified once nothing can fail anymore
+static int32_t _radix_sort(Vec v, uint32_t key_type, size_t key_offset) {
+  size_t key_size = _radix_key_size(key_type);
+
+  if (key_size == 0 || key_offset + key_size > v->elem_size) {
+    v->error = VEC_ERR__INVALID_KEY;
+    return VEC_ERR__INVALID_KEY;
+  }
+
+  if (v->size < 2) {
+    _notify(v, VEC_ACTION__SORT, v);
+    return VEC_OK;
+  }
+
+  int32_t res = _prepare_write(v);
+  if (res < 0) {
+    return res;
+  }
+
+  size_t counts[8][256];
+  memset(counts, 0, sizeof(counts));
+
+  //all digit histograms in one pass
+  for (size_t i = 0; i < v->size; i++) {
+    uint64_t key = _radix_key(v->data + (i * v->elem_size) + key_offset, key_type);
+    for (size_t d = 0; d < key_size; d++) {
+      counts[d][(key >> (d * 8)) & 0xFF]++;
+    }
+  }
+
+  //scratch buffer has full capacity so it can become the data buffer
+  char* tmp = v->allocator->malloc(v->capacity * v->elem_size);
+  if (tmp == NULL) {
+    v->error = VEC_ERR__MALLOC;
+    return VEC_ERR__MALLOC;
+  }
+
+  _notify(v, VEC_ACTION__SORT, v);
+
+  char* src = v->data;
+  char* dst = tmp;
+
+  for (size_t d = 0; d < key_size; d++) {
+    size_t* count = counts[d];
+    size_t offsets[256];
+    size_t total = 0;
+    int trivial = 0;
+
+    for (size_t b = 0; b < 256; b++) {
+      //every key has the same digit -> nothing moves
+      if (count[b] == v->size) {
+        trivial = 1;
+        break;
+      }
+      offsets[b] = total;
+      total += count[b];
+    }
+
+    if (trivial) {
+      continue;
+    }
+
+    size_t shift = d * 8;
+
+    if (v->elem_size == 4) {
+      for (size_t i = 0; i < v->size; i++) {
+        const char* elem = src + (i * 4);
+        size_t b = (_radix_key(elem + key_offset, key_type) >> shift) & 0xFF;
+        memcpy(dst + (offsets[b]++ * 4), elem, 4);
+      }
+    }
+    else if (v->elem_size == 8) {
+      for (size_t i = 0; i < v->size; i++) {
+        const char* elem = src + (i * 8);
+        size_t b = (_radix_key(elem + key_offset, key_type) >> shift) & 0xFF;
+        memcpy(dst + (offsets[b]++ * 8), elem, 8);
+      }
+    }
+    else {
+      for (size_t i = 0; i < v->size; i++) {
+        const char* elem = src + (i * v->elem_size);
+        size_t b = (_radix_key(elem + key_offset, key_type) >> shift) & 0xFF;
+        memcpy(dst + (offsets[b]++ * v->elem_size), elem, v->elem_size);
+      }
+    }
+
+    char* swap = src;
+    src = dst;
+    dst = swap;
+  }
+
+  //odd number of passes -> sorted data lives in the scratch buffer
+  if (src != v->data && _owns_heap_data(v)) {
+    v->allocator->free(v->data);
+    v->data = src;
+  }
+  else {
+    if (src != v->data) {
+      memcpy(v->data, src, v->size * v->elem_size);
+    }
+    v->allocator->free(tmp);
+  }
+
+  return VEC_OK;
+}
+
+//radix sort must agree with cmp_fn if the vector is ordered or searched by bounds
+static int32_t set_radix_key(Vec v, uint32_t key_type, size_t key_offset) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (key_type == VEC_KEY__NONE) {
+    v->radix_key_type = VEC_KEY__NONE;
+    v->flags &= ~VEC_FLAG__RADIX_SORT;
+    return VEC_OK;
+  }
+
+  size_t key_size = _radix_key_size(key_type);
+  if (key_size == 0 || key_offset + key_size > v->elem_size) {
+    v->error = VEC_ERR__INVALID_KEY;
+    return VEC_ERR__INVALID_KEY;
+  }
+
+  v->radix_key_type = key_type;
+  v->radix_key_offset = key_offset;
+  v->flags |= VEC_FLAG__RADIX_SORT;
+
+  return VEC_OK;
+}
+
+static int32_t radix_sort(Vec v, uint32_t key_type, size_t key_offset) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  return _radix_sort(v, key_type, key_offset);
+}
+
+int32_t sort(Vec v) {
+
+  if (v == NULL) {
+    return VEC_ERR__NULL_POS;
+  }
+
+  if ((v->flags & VEC_FLAG__RADIX_SORT) && v->radix_key_type != VEC_KEY__NONE) {
+    return _radix_sort(v, v->radix_key_type, v->radix_key_offset);
+  }
+
+  if (v->cmp_fn == NULL) {
+    v->error = VEC_ERR__NULL_CMP_FN;
+    return VEC_ERR__NULL_CMP_FN;
+  }
+
+  int32_t res = _prepare_write(v);
+  if (res < 0) {
+    return res;
+  }
+
+  _notify(v, VEC_ACTION__SORT, v);
+
+  if (v->flags & (VEC_FLAG__PARALLEL_SORT | VEC_FLAG__STABLE_SORT)) {
+    psort_config_t config = { 0, 0, (v->flags & VEC_FLAG__STABLE_SORT) != 0 };
+
+    //serial stable sort when parallel isn't asked for
+    if ((v->flags & VEC_FLAG__PARALLEL_SORT) == 0) {
+      config.threads = 1;
+    }
+
+    if (iPSort.sort(v->data, v->size, v->elem_size, v->cmp_fn, &config) < 0) {
+      v->error = VEC_ERR__MALLOC;
+      return VEC_ERR__MALLOC;
+    }
+
+    return VEC_OK;
+  }
+
+  qsort(v->data, v->size, v->elem_size, v->cmp_fn);
+  return VEC_OK;
+}
+
+static int32_t par_sort(Vec v, const psort_config_t* config) {
+
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (v->cmp_fn == NULL) {
+    v->error = VEC_ERR__NULL_CMP_FN;
+    return VEC_ERR__NULL_CMP_FN;
+  }
+
+  int32_t res = _prepare_write(v);
+  if (res < 0) {
+    return res;
+  }
+
+  _notify(v, VEC_ACTION__SORT, v);
+
+  if (iPSort.sort(v->data, v->size, v->elem_size, v->cmp_fn, config) < 0) {
+    v->error = VEC_ERR__MALLOC;
+    return VEC_ERR__MALLOC;
+  }
+
+  return VEC_OK;
+}
+
+//serialization: header, per chunk checksums (optional), raw payload
+//numbers are stored in native byte order
+#define VEC_IO_MAGIC					0x53434556u		//"VECS"
+#define VEC_IO_VERSION				1
+#define VEC_IO_MAX_BUFS				64
+
+//flags that describe the data, not the Vec object
+#define VEC_IO_FLAGS					(VEC_FLAG__STATIC | VEC_FLAG__RECURSIVE_DESTRUCTION | VEC_FLAG__ORDERED \
+															| VEC_FLAG__PARALLEL_SORT | VEC_FLAG__STABLE_SORT | VEC_FLAG__RADIX_SORT)
+
+typedef struct {
+	uint32_t	magic;
+	uint16_t	version;
+	uint16_t	header_size;
+	uint32_t	flags;
+	uint32_t	options;
+	uint64_t	elem_size;
+	uint64_t	count;
+	uint64_t	chunk_size;
+	uint32_t	radix_key_type;
+	uint32_t	reserved;
+	uint64_t	radix_key_offset;
+	uint64_t	reserved2;
+} vec_io_header_t;
+
+typedef struct {
+	const char*	base;
+	size_t			length;
+} vec_io_buf_t;
+
+//FNV-1a over 64 bit words
+static uint64_t _checksum(const char* data, size_t length) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  size_t i = 0;
+
+  for (; i + 8 <= length; i += 8) {
+    uint64_t word;
+    memcpy(&word, data + i, 8);
+    hash = (hash ^ word) * 0x100000001b3ull;
+  }
+
+  for (; i < length; i++) {
+    hash = (hash ^ (unsigned char)data[i]) * 0x100000001b3ull;
+  }
+
+  return hash;
+}
+
+static size_t _io_chunk_count(size_t bytes) {
+  return (bytes + VEC_IO_CHUNK_SIZE - 1) / VEC_IO_CHUNK_SIZE;
+}
+
+//gathered write, retried until everything is out
+static int32_t _write_bufs(int fd, vec_io_buf_t* bufs, size_t count) {
+#if defined(_WIN32)
+  for (size_t i = 0; i < count; i++) {
+    const char* ptr = bufs[i].base;
+    size_t left = bufs[i].length;
+
+    while (left > 0) {
+      unsigned int part = left > VEC_IO_CHUNK_SIZE ? VEC_IO_CHUNK_SIZE : (unsigned int)left;
+      int written = _write(fd, ptr, part);
+      if (written <= 0) {
+        return VEC_ERR__IO;
+      }
+      ptr += written;
+      left -= written;
+    }
+  }
+#else
+  struct iovec iov[VEC_IO_MAX_BUFS];
+  size_t next = 0;
+
+  while (next < count) {
+    int iov_count = 0;
+    for (; next < count && iov_count < VEC_IO_MAX_BUFS; next++) {
+      if (bufs[next].length > 0) {
+        iov[iov_count].iov_base = (void*)bufs[next].base;
+        iov[iov_count].iov_len = bufs[next].length;
+        iov_count++;
+      }
+    }
+
+    struct iovec* it = iov;
+    while (iov_count > 0) {
+      ssize_t written = writev(fd, it, iov_count);
+      if (written <= 0) {
+        return VEC_ERR__IO;
+      }
+
+      //skip what went out, a partial write leaves the rest of one iovec
+      while (iov_count > 0 && (size_t)written >= it->iov_len) {
+        written -= it->iov_len;
+        it++;
+        iov_count--;
+      }
+      if (iov_count > 0) {
+        it->iov_base = (char*)it->iov_base + written;
+        it->iov_len -= written;
+      }
+    }
+  }
+#endif
+
+  return VEC_OK;
+}
+
+static int32_t _read_all(int fd, char* dst, size_t length) {
+  while (length > 0) {
+    size_t part = length > VEC_IO_CHUNK_SIZE ? VEC_IO_CHUNK_SIZE : length;
+#if defined(_WIN32)
+    int got = _read(fd, dst, (unsigned int)part);
+#else
+    ssize_t got = read(fd, dst, part);
+#endif
+    if (got <= 0) {
+      return VEC_ERR__IO;
+    }
+    dst += got;
+    length -= got;
+  }
+
+  return VEC_OK;
+}
+
+static int32_t save(const Vec v, int fd, uint32_t options) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  size_t bytes = v->size * v->elem_size;
+  size_t chunks = _io_chunk_count(bytes);
+  size_t sums_count = (options & VEC_SAVE__CHECKSUMS) ? chunks : 0;
+
+  vec_io_header_t header;
+  memset(&header, 0, sizeof(header));
+  header.magic = VEC_IO_MAGIC;
+  header.version = VEC_IO_VERSION;
+  header.header_size = sizeof(vec_io_header_t);
+  header.flags = v->flags & VEC_IO_FLAGS;
+  header.options = options & VEC_SAVE__CHECKSUMS;
+  header.elem_size = v->elem_size;
+  header.count = v->size;
+  header.chunk_size = VEC_IO_CHUNK_SIZE;
+  header.radix_key_type = v->radix_key_type;
+  header.radix_key_offset = v->radix_key_offset;
+
+  uint64_t* sums = NULL;
+  if (sums_count > 0) {
+    sums = v->allocator->malloc(sums_count * sizeof(uint64_t));
+    if (sums == NULL) {
+      v->error = VEC_ERR__MALLOC;
+      return VEC_ERR__MALLOC;
+    }
+
+    for (size_t i = 0; i < chunks; i++) {
+      size_t offset = i * VEC_IO_CHUNK_SIZE;
+      size_t length = bytes - offset < VEC_IO_CHUNK_SIZE ? bytes - offset : VEC_IO_CHUNK_SIZE;
+      sums[i] = _checksum(v->data + offset, length);
+    }
+  }
+
+  //header and checksums go out with the first payload chunks in one call
+  vec_io_buf_t bufs[VEC_IO_MAX_BUFS];
+  size_t buf_count = 0;
+  int32_t res = VEC_OK;
+
+  bufs[buf_count++] = (vec_io_buf_t){ (const char*)&header, sizeof(header) };
+  bufs[buf_count++] = (vec_io_buf_t){ (const char*)sums, sums_count * sizeof(uint64_t) };
+
+  for (size_t i = 0; i < chunks && res == VEC_OK; i++) {
+    size_t offset = i * VEC_IO_CHUNK_SIZE;
+    size_t length = bytes - offset < VEC_IO_CHUNK_SIZE ? bytes - offset : VEC_IO_CHUNK_SIZE;
+    bufs[buf_count++] = (vec_io_buf_t){ v->data + offset, length };
+
+    if (buf_count == VEC_IO_MAX_BUFS) {
+      res = _write_bufs(fd, bufs, buf_count);
+      buf_count = 0;
+    }
+  }
+
+  if (res == VEC_OK && buf_count > 0) {
+    res = _write_bufs(fd, bufs, buf_count);
+  }
+
+  if (sums != NULL) {
+    v->allocator->free(sums);
+  }
+
+  if (res < 0) {
+    v->error = res;
+  }
+
+  return res;
+}
+
+//elements are read straight into the Vec data, ordered vectors aren't sorted again
+//compare function and element destructor are not stored, set them after load
+static Vec load(int fd, int32_t* error) {
+  vec_io_header_t header;
+  uint64_t* sums = NULL;
+  Vec v = NULL;
+  int32_t res = _read_all(fd, (char*)&header, sizeof(header));
+
+  if (res < 0) {
+    goto done;
+  }
+
+  if (header.magic != VEC_IO_MAGIC || header.version != VEC_IO_VERSION || header.header_size != sizeof(header)
+    || header.elem_size == 0 || header.chunk_size == 0 || header.count > SIZE_MAX / header.elem_size) {
+    res = VEC_ERR__BAD_FORMAT;
+    goto done;
+  }
+
+  size_t bytes = (size_t)(header.count * header.elem_size);
+  size_t chunk_size = (size_t)header.chunk_size;
+  size_t chunks = (bytes + chunk_size - 1) / chunk_size;
+
+  v = construct_with_allocator_and_data((size_t)header.elem_size, CurrentAllocator, NULL, 0, 0);
+  if (v == NULL) {
+    res = VEC_ERR__VECTOR_CONSTRUCT;
+    goto done;
+  }
+
+  if ((header.options & VEC_SAVE__CHECKSUMS) && chunks > 0) {
+    sums = v->allocator->malloc(chunks * sizeof(uint64_t));
+    if (sums == NULL) {
+      res = VEC_ERR__MALLOC;
+      goto done;
+    }
+
+    res = _read_all(fd, (char*)sums, chunks * sizeof(uint64_t));
+    if (res < 0) {
+      goto done;
+    }
+  }
+
+  if (header.count > 0) {
+    res = reserve(v, (size_t)header.count);
+    if (res < 0) {
+      goto done;
+    }
+  }
+
+  for (size_t i = 0; i < chunks; i++) {
+    size_t offset = i * chunk_size;
+    size_t length = bytes - offset < chunk_size ? bytes - offset : chunk_size;
+
+    res = _read_all(fd, v->data + offset, length);
+    if (res < 0) {
+      goto done;
+    }
+
+    if (sums != NULL && _checksum(v->data + offset, length) != sums[i]) {
+      res = VEC_ERR__CHECKSUM;
+      goto done;
+    }
+  }
+
+  v->size = (size_t)header.count;
+  v->flags = header.flags & VEC_IO_FLAGS;
+  v->radix_key_type = header.radix_key_type;
+  v->radix_key_offset = (size_t)header.radix_key_offset;
+
+done:
+  if (sums != NULL) {
+    v->allocator->free(sums);
+  }
+
+  if (res < 0 && v != NULL) {
+    destruct(v);
+    v = NULL;
+  }
+
+  if (error != NULL) {
+    *error = res;
+  }
+
+  return v;
+}
+
+//notification
+int32_t subscribe(Vec v, uint64_t action_mask, void (*cb)(uint64_t action_flag, const void* calling_extra, void* cb_extra), void* cb_extra, int auto_free_extra) {
+  if (v->observer == NULL) {
+    v->observer = iObserver.construct();
+    if (v->observer == NULL) {
+      v->error = VEC_ERR__OBSERVER_CONSTRUCT;
+      return VEC_ERR__OBSERVER_CONSTRUCT;
+    }
+  }
+
+  return iObserver.subscribe(v->observer, action_mask, cb, cb_extra, auto_free_extra);
+}
+
+void*  unsubscribe(Vec v, uint64_t action_mask, void (*cb)(uint64_t action_flag, const void* calling_extra, void* cb_extra)) {
+  return iObserver.unsubscribe(v->observer, action_mask, cb);
+}
+
+static int32_t detach_index(Vec v) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (v->index == NULL) {
+    v->error = VEC_ERR__NO_INDEX;
+    return VEC_ERR__NO_INDEX;
+  }
+
+  iObserver.unsubscribe(v->observer, VEC_INDEX_ACTIONS, _index_cb);
+  _index_free(v);
+
+  return VEC_OK;
+}
+
+//attaching again replaces the index
+static int32_t attach_index(Vec v, size_t key_offset, size_t key_size, hmap_hash_fn hash, hmap_eq_fn eq) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (key_size == 0 || key_offset + key_size > v->elem_size) {
+    v->error = VEC_ERR__INVALID_KEY;
+    return VEC_ERR__INVALID_KEY;
+  }
+
+  if (v->flags & VEC_FLAG__ASYNC_NOTIFY) {
+    v->error = VEC_ERR__ASYNC_INDEX;
+    return VEC_ERR__ASYNC_INDEX;
+  }
+
+  if (v->index != NULL) {
+    detach_index(v);
+  }
+
+  if (v->observer == NULL) {
+    v->observer = iObserver.construct();
+    if (v->observer == NULL) {
+      v->error = VEC_ERR__OBSERVER_CONSTRUCT;
+      return VEC_ERR__OBSERVER_CONSTRUCT;
+    }
+  }
+
+  vec_index_t* index = v->allocator->malloc(sizeof(vec_index_t));
+  if (index == NULL) {
+    v->error = VEC_ERR__MALLOC;
+    return VEC_ERR__MALLOC;
+  }
+
+  index->vector = v;
+  index->key_offset = key_offset;
+  index->key_size = key_size;
+  index->eq = eq != NULL ? eq : _index_eq_bytes;
+  index->map = iHMap.construct_with_allocator(key_size, sizeof(size_t), hash, eq, v->allocator);
+  v->index = index;
+
+  if (index->map == NULL || _index_rebuild(index) < 0 || iObserver.subscribe(v->observer, VEC_INDEX_ACTIONS, _index_cb, index, 0) < 0) {
+    _index_free(v);
+    v->error = VEC_ERR__MALLOC;
+    return VEC_ERR__MALLOC;
+  }
+
+  return VEC_OK;
+}
+
+static int32_t reindex(Vec v) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (v->index == NULL) {
+    v->error = VEC_ERR__NO_INDEX;
+    return VEC_ERR__NO_INDEX;
+  }
+
+  return _index_rebuild(v->index);
+}
+
+static void* find_by_key(const Vec v, const void* key) {
+  if (v == NULL || key == NULL) {
+    return NULL;
+  }
+
+  if (v->index == NULL) {
+    v->error = VEC_ERR__NO_INDEX;
+    return NULL;
+  }
+
+  int usable;
+  char* ptr = _index_find(v, key, &usable);
+  if (usable) {
+    return ptr;
+  }
+
+  //open batch or failed rebuild: the index can't answer
+  for (size_t i = 0; i < v->size; i++) {
+    ptr = v->data + (i * v->elem_size);
+    if (v->index->eq(ptr + v->index->key_offset, key, v->index->key_size)) {
+      return ptr;
+    }
+  }
+
+  return NULL;
+}
+
+//payload offset after an extra struct in a snapshot
+static inline size_t _snapshot_head(size_t size) {
+  return (size + sizeof(max_align_t) - 1) & ~(sizeof(max_align_t) - 1);
+}
+
+//copies an action extra for async delivery, element payloads follow the struct. Erase and
+//replace positions point to copies of the removed elements. Extras holding a Vec or caller
+//data that can't be copied are delivered inline
+static size_t _snapshot_extra(int action, const void* extra, void* out, size_t out_size) {
+  char* bytes = out;
+
+  switch (action) {
+    case VEC_ACTION__ADD: {
+      const add_action_extra_t* src = extra;
+      size_t head = _snapshot_head(sizeof(*src));
+      size_t needed = head + (src->elem != NULL ? src->vector->elem_size : 0);
+      if (needed > out_size) {
+        return needed;
+      }
+
+      add_action_extra_t* ad = out;
+      *ad = *src;
+      if (src->elem != NULL) {
+        memcpy(bytes + head, src->elem, src->vector->elem_size);
+        ad->elem = bytes + head;
+      }
+      return needed;
+    }
+    case VEC_ACTION__INSERT: {
+      const insert_action_extra_t* src = extra;
+      size_t head = _snapshot_head(sizeof(*src));
+      size_t needed = head + (src->elem != NULL ? src->vector->elem_size : 0);
+      if (needed > out_size) {
+        return needed;
+      }
+
+      insert_action_extra_t* id = out;
+      *id = *src;
+      if (src->elem != NULL) {
+        memcpy(bytes + head, src->elem, src->vector->elem_size);
+        id->elem = bytes + head;
+      }
+      return needed;
+    }
+    case VEC_ACTION__REPLACE: {
+      //new element, then the replaced one
+      const replace_action_extra_t* src = extra;
+      size_t elem_size = src->vector->elem_size;
+      size_t head = _snapshot_head(sizeof(*src));
+      size_t needed = head + (2 * elem_size);
+      if (needed > out_size) {
+        return needed;
+      }
+
+      replace_action_extra_t* rd = out;
+      *rd = *src;
+      if (src->elem != NULL) {
+        memcpy(bytes + head, src->elem, elem_size);
+        rd->elem = bytes + head;
+      }
+      if (src->pos != NULL) {
+        memcpy(bytes + head + elem_size, src->pos, elem_size);
+        rd->pos = bytes + head + elem_size;
+      }
+      return needed;
+    }
+    case VEC_ACTION__INSERT_RANGE: {
+      const insert_range_action_extra_t* src = extra;
+      size_t head = _snapshot_head(sizeof(*src));
+      size_t payload = src->count * src->vector->elem_size;
+      if (head + payload > out_size) {
+        return head + payload;
+      }
+
+      insert_range_action_extra_t* id = out;
+      *id = *src;
+      if (payload > 0) {
+        memcpy(bytes + head, src->elems, payload);
+        id->elems = bytes + head;
+      }
+      return head + payload;
+    }
+    case VEC_ACTION__ERASE: {
+      const erase_action_extra_t* src = extra;
+      size_t head = _snapshot_head(sizeof(*src));
+      size_t needed = head + src->vector->elem_size;
+      if (needed > out_size) {
+        return needed;
+      }
+
+      erase_action_extra_t* ed = out;
+      *ed = *src;
+      if (src->pos != NULL) {
+        memcpy(bytes + head, src->pos, src->vector->elem_size);
+        ed->pos = bytes + head;
+      }
+      return needed;
+    }
+    case VEC_ACTION__ERASE_RANGE: {
+      const erase_range_action_extra_t* src = extra;
+      size_t head = _snapshot_head(sizeof(*src));
+      size_t payload = (size_t)((const char*)src->last - (const char*)src->first);
+      if (head + payload > out_size) {
+        return head + payload;
+      }
+
+      erase_range_action_extra_t* ed = out;
+      *ed = *src;
+      if (payload > 0) {
+        memcpy(bytes + head, src->first, payload);
+      }
+      ed->first = bytes + head;
+      ed->last = bytes + head + payload;
+      return head + payload;
+    }
+    case VEC_ACTION__BATCH: {
+      const batch_action_extra_t* src = extra;
+      size_t head = _snapshot_head(sizeof(*src));
+      size_t payload = src->range_count * sizeof(vec_range_t);
+      if (head + payload > out_size) {
+        return head + payload;
+      }
+
+      batch_action_extra_t* bd = out;
+      *bd = *src;
+      if (payload > 0) {
+        memcpy(bytes + head, src->ranges, payload);
+        bd->ranges = (const vec_range_t*)(bytes + head);
+      }
+      return head + payload;
+    }
+    case VEC_ACTION__RESIZE:
+      if (sizeof(resize_action_extra_t) > out_size) {
+        return sizeof(resize_action_extra_t);
+      }
+      memcpy(out, extra, sizeof(resize_action_extra_t));
+      return sizeof(resize_action_extra_t);
+    default:
+      //APPEND, ERASE_IF, FILTER and SLICE hold other Vecs or the predicate's extra, the rest
+      //pass the Vec itself, which is only consistent before the mutation runs
+      return OBS_SNAPSHOT_INLINE;
+  }
+}
+
+//subscribers run on a dispatcher thread, queued events are delivered before destruct returns
+static int32_t start_async_notify(Vec v, const obs_async_config_t* config) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  //a hash index has to see every change before find runs
+  if (v->index != NULL) {
+    v->error = VEC_ERR__ASYNC_INDEX;
+    return VEC_ERR__ASYNC_INDEX;
+  }
+
+  if (v->observer == NULL) {
+    v->observer = iObserver.construct();
+    if (v->observer == NULL) {
+      v->error = VEC_ERR__OBSERVER_CONSTRUCT;
+      return VEC_ERR__OBSERVER_CONSTRUCT;
+    }
+  }
+
+  obs_async_config_t cfg = { 0, OBS_ASYNC__BLOCK, NULL };
+  if (config != NULL) {
+    cfg = *config;
+  }
+  if (cfg.snapshot == NULL) {
+    cfg.snapshot = _snapshot_extra;
+  }
+
+  if (iObserver.start_async(v->observer, &cfg) < 0) {
+    v->error = VEC_ERR__OBSERVER_CONSTRUCT;
+    return VEC_ERR__OBSERVER_CONSTRUCT;
+  }
+
+  v->flags |= VEC_FLAG__ASYNC_NOTIFY;
+  return VEC_OK;
+}
+
+static int32_t stop_async_notify(Vec v) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  iObserver.stop_async(v->observer);
+  v->flags &= ~VEC_FLAG__ASYNC_NOTIFY;
+  return VEC_OK;
+}
+
+static int32_t flush_notify(Vec v) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  iObserver.flush(v->observer);
+  return VEC_OK;
+}
+
+//batches nest, only the outermost commit notifies
+static int32_t begin_batch(Vec v) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  if (v->batch != NULL) {
+    v->batch->depth++;
+    return VEC_OK;
+  }
+
+  v->batch = v->allocator->malloc(sizeof(vec_batch_t));
+  if (v->batch == NULL) {
+    v->error = VEC_ERR__MALLOC;
+    return VEC_ERR__MALLOC;
+  }
+
+  v->batch->depth = 1;
+  v->batch->actions = 0;
+  v->batch->operations = 0;
+  v->batch->added = 0;
+  v->batch->start_size = v->size;
+  v->batch->range_count = 0;
+
+  return VEC_OK;
+}
+
+//one VEC_ACTION__BATCH event for everything recorded, nothing if nothing changed
+static int32_t commit_batch(Vec v) {
+  if (v == NULL) {
+    return VEC_ERR__NULL_VEC;
+  }
+
+  vec_batch_t* batch = v->batch;
+  if (batch == NULL) {
+    v->error = VEC_ERR__NO_BATCH;
+    return VEC_ERR__NO_BATCH;
+  }
+
+  if (--batch->depth > 0) {
+    return VEC_OK;
+  }
+
+  v->batch = NULL;
+  int32_t res = VEC_OK;
+
+  if (batch->operations > 0) {
+    //ranges were recorded against intermediate sizes
+    size_t count = 0;
+    for (size_t i = 0; i < batch->range_count; i++) {
+      vec_range_t range = batch->ranges[i];
+      if (range.last > v->size) {
+        range.last = v->size;
+      }
+      if (range.first < range.last) {
+        batch->ranges[count++] = range;
+      }
+    }
+
+    batch_action_extra_t bd = {
+      .vector = v,
+      .actions = batch->actions,
+      .operations = batch->operations,
+      .added = batch->added,
+      .removed = batch->start_size + batch->added - v->size,
+      .ranges = batch->ranges,
+      .range_count = count
+    };
+
+    res = iObserver.notify(v->observer, VEC_ACTION__BATCH, &bd);
+    if (res == OBS_ERR__NULL_OBSERVER) {
+      res = VEC_OK;
+    }
+  }
+
+  v->allocator->free(batch);
+
+  return res;
+}
+
+VectorInterface iVec = {
+  .construct = construct,
+  .construct_from_data = construct_from_data,
+  .construct_with_allocator = construct_with_allocator,
+  .construct_with_inline_capacity = construct_with_inline_capacity,
+  .construct_mapped = construct_mapped,
+  .destruct = destruct,
+  .flush = flush,
+
+  .copy = copy,
+  .filter = filter,
+  .slice = slice,
+  .is_shared = is_shared,
+
+  .view = view,
+  .subview = subview,
+  .view_at = view_at,
+  .view_to_vec = view_to_vec,
 
   .size = size,
   .capacity = capacity,
@@ -768,6 +3126,7 @@ VectorInterface iVec = {
   .error = error,
 
   .set_compare_fn = set_compare_fn,
+  .set_elem_destructor = set_elem_destructor,
   .release_data = release_data,
   .get_data_copy = get_data_copy,
 
@@ -776,11 +3135,14 @@ VectorInterface iVec = {
 
   .add = add,
   .insert = insert,
+  .insert_range = insert_range,
   .append = append,
 
   .clear = clear,
   .erase = erase,
   .erase_at = erase_at,
+  .erase_range = erase_range,
+  .erase_if = erase_if,
 
   .at = at,
   .begin = begin,
@@ -788,6 +3150,35 @@ VectorInterface iVec = {
   .back = back,
   .next = next,
   .for_each = for_each,
-  .find = find
+  .par_for_each = par_for_each,
+  .par_reduce = par_reduce,
+  .par_filter = par_filter,
+  .find = find,
+  .replace = replace,
+  .replace_at = replace_at,
+  .sort = sort,
+  .par_sort = par_sort,
+  .subscribe = subscribe,
+  .unsubscribe = unsubscribe,
+  .begin_batch = begin_batch,
+  .commit_batch = commit_batch,
+  .start_async_notify = start_async_notify,
+  .stop_async_notify = stop_async_notify,
+  .flush_notify = flush_notify,
+  .attach_index = attach_index,
+  .detach_index = detach_index,
+  .reindex = reindex,
+  .find_by_key = find_by_key,
+  .save = save,
+  .load = load,
+  .radix_sort = radix_sort,
+  .set_radix_key = set_radix_key,
+  .lower_bound = lower_bound,
+  .upper_bound = upper_bound,
+  .equal_range = equal_range,
+  .contains = contains,
+  .find_bytes = find_bytes,
+  .count_equal = count_equal,
+  .find_all_indices = find_all_indices
 };
 